@@ -0,0 +1,181 @@
+/*
+ * File: agent_abi.h
+ * Author: Joshua T. Guerin
+ * Purpose: A stable, C-compatible interface between the tournament and
+ *          agents, so agents can be compiled into shared objects and
+ *          chosen at runtime (see registry.h).
+ *
+ * Notes: Only plain C types cross the interface.  Any agent that follows
+ *        the usual agent contract (agent(player), next_move(isola),
+ *        name()) can be exported by adding one line to its .cpp file:
+ *            ISOLA_EXPORT_AGENT(my_namespace::agent)
+ *        The line does nothing unless compiled with -DISOLA_PLUGIN (see
+ *        the plugins target of the Makefile).
+ *        Optional hooks (agent_traits.h) are forwarded when the agent
+ *        declares them.
+ */
+
+#ifndef AGENT_ABI_H
+#define AGENT_ABI_H
+
+#include <chrono>  // Timing the adapter's own work
+#include <string>  // Agent names
+#include <utility> // move()
+#include <vector>  // Rebuilding the board
+
+#include "agent_traits.h" // Optional agent hooks
+#include "isola.h"        // Game logic
+#include "seeds.h"        // Agents' seeds
+#include "types.h"        // Isola/tournament types.
+
+// Bumped whenever any struct below changes layout or meaning.
+#define ISOLA_AGENT_ABI_VERSION 5
+
+// Name of the function every plugin exports (type isola_agent_entry).
+#define ISOLA_AGENT_ENTRY "isola_agent_plugin_entry"
+
+extern "C" {
+  struct isola_board_view {
+    /*
+     * A read-only view of the board: size*size cells in row-major order,
+     * each one of ' ', 'X', 'b' or 'w'.
+     */
+    unsigned size;
+    const char* cells;
+  };
+
+  struct isola_move {
+    /*
+     * An action: move_to is a direction (north=0 ... southeast=7, in the
+     * order of types.h), followed by the square to remove.
+     */
+    int move_to;
+    unsigned remove_row, remove_col;
+  };
+
+  struct isola_agent_plugin {
+    /*
+     * Function table describing one agent.  Agent instances are opaque.
+     */
+    unsigned abi_version;
+    const char* (*name)();
+    void* (*create)(char color, unsigned seed);
+    // seed restarts agent_seed() (seeds.h) while the agent is constructed.
+    void (*destroy)(void* agent);
+    isola_move (*next_move)(void* agent, const isola_board_view* board);
+    unsigned long long (*overhead_ns)(void* agent);
+    // Time the agent's side has spent converting boards (nanoseconds).
+    void (*opponent_moved)(void* agent, const isola_move* move);
+    // The opponent's last move (see agent_traits.h); may do nothing.
+    void (*ponder)(void* agent, const isola_board_view* board,
+		   const ponder_signal* signal);
+    // Thinks on the opponent's time until signalled; may return at once.
+    // Null if the agent has no ponder() hook.
+  };
+
+  typedef const isola_agent_plugin* (*isola_agent_entry)();
+}
+
+
+template <typename TAgent>
+class plugin_adapter {
+  /*
+   * Description: Implements the isola_agent_plugin table for a C++ agent.
+   *              Used directly for built-in agents and through
+   *              ISOLA_EXPORT_AGENT for shared objects.
+   */
+ private:
+  struct instance {
+    TAgent agent;
+    unsigned long long overhead_ns;
+    instance(player c) : agent(c), overhead_ns(0) {}
+  };
+
+  static const char* name() {
+    static const std::string agent_name = agent_name_of<TAgent>::name();
+    return agent_name.c_str();
+  }
+
+  static void* create(char color, unsigned seed) {
+    // A plugin has its own copy of seeds.h, so the tournament's seeds
+    // are passed in.  The caller's seeds are left as they were.
+    std::mt19937 caller_seeds = agent_seeds();
+    seed_agents(seed);
+    instance* agent = new instance(player(color));
+    agent_seeds() = caller_seeds;
+    return agent;
+  }
+
+  static void destroy(void* agent) {
+    delete static_cast<instance*>(agent);
+  }
+
+  static isola rebuild(const isola_board_view* view) {
+    std::vector<std::vector<char> > cells(view->size);
+    for(unsigned i=0; i<view->size; i++)
+      cells[i].assign(view->cells + i*view->size,
+		      view->cells + (i+1)*view->size);
+    return isola(std::move(cells));
+  }
+
+  static isola_move next_move(void* agent, const isola_board_view* view) {
+    instance* self = static_cast<instance*>(agent);
+    std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+
+    // Rebuild the board.  This takes the place of the copy made when
+    // next_move(isola) is called directly, so it is the only extra work.
+    isola board = rebuild(view);
+
+    self->overhead_ns += std::chrono::duration_cast<std::chrono::nanoseconds>
+      (std::chrono::steady_clock::now() - start).count();
+
+    action next = self->agent.next_move(std::move(board));
+
+    isola_move result;
+    result.move_to = next.move_to;
+    result.remove_row = next.remove.row;
+    result.remove_col = next.remove.col;
+    return result;
+  }
+
+  static unsigned long long overhead_ns(void* agent) {
+    return static_cast<instance*>(agent)->overhead_ns;
+  }
+
+  static void ponder(void* agent, const isola_board_view* view,
+		     const ponder_signal* signal) {
+    // Pondering is off the clock, so the rebuild is not counted.
+    ponder_agent(static_cast<instance*>(agent)->agent, rebuild(view),
+		 *signal);
+  }
+
+  static void opponent_moved(void* agent, const isola_move* move) {
+    notify_opponent_move(static_cast<instance*>(agent)->agent,
+			 action(direction(move->move_to),
+				location(move->remove_row,
+					 move->remove_col)));
+  }
+
+ public:
+  static const isola_agent_plugin* table() {
+    static const isola_agent_plugin functions = {
+      ISOLA_AGENT_ABI_VERSION, &name, &create, &destroy, &next_move,
+      &overhead_ns, &opponent_moved,
+      has_ponder<TAgent>::value ? &ponder : 0
+    };
+    return &functions;
+  }
+};
+
+
+#ifdef ISOLA_PLUGIN
+#define ISOLA_EXPORT_AGENT(TAgent)					\
+  extern "C" const isola_agent_plugin* isola_agent_plugin_entry() {	\
+    return plugin_adapter<TAgent>::table();				\
+  }
+#else
+#define ISOLA_EXPORT_AGENT(TAgent)
+#endif
+
+#endif
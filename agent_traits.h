@@ -0,0 +1,235 @@
+/*
+ * File: agent_traits.h
+ * Author: Joshua T. Guerin
+ * Purpose: Optional parts of the agent contract.  Beyond the required
+ *          agent(player), next_move(isola) and name(), an agent may
+ *          declare
+ *              void opponent_moved(const action& a);
+ *          to be told each move its opponent makes (called after the move
+ *          is applied, before the agent's next next_move()).  Search
+ *          agents use it to reuse the previous search, e.g., re-rooting a
+ *          tree in the subtree the opponent's move landed in.
+ *              void ponder(isola board, const ponder_signal& signal);
+ *          to think on the opponent's time.  board is the position after
+ *          the agent's own move; the agent searches until
+ *          signal.stop_requested(), then learns the actual reply through
+ *          opponent_moved().  ponder() runs on a background thread (see
+ *          ponderer) while the opponent computes its move.
+ *
+ * Notes: Agents without the hooks need no changes; game loops call
+ *        notify_opponent_move() and ponderer::start() for every agent and
+ *        they do nothing unless the hook exists.
+ */
+
+#ifndef AGENT_TRAITS_H
+#define AGENT_TRAITS_H
+
+#include <atomic>      // Stop flag
+#include <string>      // Agent names
+#include <thread>      // Pondering thread
+#include <type_traits> // true_type, false_type, enable_if
+#include <utility>     // declval(), move()
+
+#include "isola.h" // Game logic
+#include "types.h" // Isola/tournament types.
+
+
+template <typename TAgent>
+class has_agent_name {
+  /*
+   * Description: value is true if TAgent's static agent_name is public.
+   */
+  template <typename T>
+  static auto test(int) -> decltype(std::string(T::agent_name),
+				    std::true_type());
+
+  template <typename T>
+  static std::false_type test(...);
+
+ public:
+  static const bool value = decltype(test<TAgent>(0))::value;
+};
+
+
+template <typename TAgent, bool = has_agent_name<TAgent>::value>
+struct agent_name_of {
+  /*
+   * Description: name() is TAgent's name, from its static agent_name
+   *              without constructing an agent.  Agents chosen at runtime
+   *              specialize it (see registry.h).
+   */
+  static std::string name() { return TAgent::agent_name; }
+};
+
+template <typename TAgent>
+struct agent_name_of<TAgent, false> {
+  // agent_name is private: one agent is constructed, once, for its name.
+  static std::string name() {
+    static const std::string agent_name = TAgent(black).name();
+    return agent_name;
+  }
+};
+
+
+struct ponder_signal {
+  /*
+   * Tells a pondering agent when to stop.  A plain struct (a C function
+   * and its argument) so that it can cross the plugin interface.
+   */
+  int (*requested)(const void* context);
+  const void* context;
+
+  bool stop_requested() const { return requested(context) != 0; }
+};
+
+
+template <typename TAgent>
+class has_opponent_moved {
+  /*
+   * Description: value is true if TAgent declares opponent_moved(action).
+   */
+  template <typename T>
+  static auto test(int) -> decltype(std::declval<T&>().opponent_moved(
+				      std::declval<const action&>()),
+				    std::true_type());
+
+  template <typename T>
+  static std::false_type test(...);
+
+ public:
+  static const bool value = decltype(test<TAgent>(0))::value;
+};
+
+
+template <typename TAgent>
+typename std::enable_if<has_opponent_moved<TAgent>::value>::type
+notify_opponent_move(TAgent& agent, const action& a) {
+  agent.opponent_moved(a);
+}
+
+template <typename TAgent>
+typename std::enable_if<!has_opponent_moved<TAgent>::value>::type
+notify_opponent_move(TAgent&, const action&) {}
+
+
+template <typename TAgent>
+class has_ponder {
+  /*
+   * Description: value is true if TAgent declares ponder(isola,
+   *              ponder_signal).
+   */
+  template <typename T>
+  static auto test(int) -> decltype(std::declval<T&>().ponder(
+				      std::declval<isola>(),
+				      std::declval<const ponder_signal&>()),
+				    std::true_type());
+
+  template <typename T>
+  static std::false_type test(...);
+
+ public:
+  static const bool value = decltype(test<TAgent>(0))::value;
+};
+
+
+template <typename TAgent>
+typename std::enable_if<has_ponder<TAgent>::value>::type
+ponder_agent(TAgent& agent, isola board, const ponder_signal& signal) {
+  agent.ponder(std::move(board), signal);
+}
+
+template <typename TAgent>
+typename std::enable_if<!has_ponder<TAgent>::value>::type
+ponder_agent(TAgent&, isola, const ponder_signal&) {}
+
+
+template <typename TAgent>
+class has_can_ponder {
+  /*
+   * Description: value is true if TAgent declares can_ponder(), i.e.,
+   *              whether it ponders is only known at runtime (e.g., an
+   *              agent loaded from a plugin, see registry.h).
+   */
+  template <typename T>
+  static auto test(int) -> decltype(std::declval<T&>().can_ponder(),
+				    std::true_type());
+
+  template <typename T>
+  static std::false_type test(...);
+
+ public:
+  static const bool value = decltype(test<TAgent>(0))::value;
+};
+
+
+template <typename TAgent>
+typename std::enable_if<has_can_ponder<TAgent>::value, bool>::type
+agent_ponders(TAgent& agent) {
+  return agent.can_ponder();
+}
+
+template <typename TAgent>
+typename std::enable_if<!has_can_ponder<TAgent>::value, bool>::type
+agent_ponders(TAgent&) {
+  return has_ponder<TAgent>::value;
+}
+
+
+class ponderer {
+  /*
+   * Description: Runs one agent's ponder() on a background thread.  The
+   *              game loop calls start() after the agent moves and stop()
+   *              as soon as the opponent's reply is known (before telling
+   *              the agent about it).  The destructor stops the thread, so
+   *              declare a ponderer after the agents it is used with.
+   */
+ private:
+  std::thread worker;
+  std::atomic<bool> stop_flag;
+  ponder_signal signal;
+
+  static int flag_set(const void* context) {
+    return static_cast<const std::atomic<bool>*>(context)->load();
+  }
+
+  ponderer(const ponderer&);
+  ponderer& operator=(const ponderer&);
+
+ public:
+  ponderer() : stop_flag(false) {
+    signal.requested = &flag_set;
+    signal.context = &stop_flag;
+  }
+
+  ~ponderer() { stop(); }
+
+  template <typename TAgent>
+  void start(TAgent& agent, const isola& board) {
+    /*
+     * Description: Starts agent pondering on a copy of board (no thread
+     *              is started unless agent_ponders(agent)).  Stops any
+     *              earlier pondering first.
+     */
+    stop();
+    if(!agent_ponders(agent))
+      return;
+
+    stop_flag = false;
+    isola position = board;
+    worker = std::thread([this, &agent, position]() {
+	ponder_agent(agent, position, signal);
+      });
+  }
+
+  void stop() {
+    /*
+     * Description: Signals the pondering agent and waits for it to return.
+     */
+    if(worker.joinable()) {
+      stop_flag = true;
+      worker.join();
+    }
+  }
+};
+
+#endif
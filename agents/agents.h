@@ -0,0 +1,30 @@
+/*
+ * File: agents.h
+ * Author: Joshua T. Guerin
+ * Description: Registers every agent in the agents directory in a single
+ *              compile-time list.  League play (see league.h) runs a
+ *              round-robin between all of the agents listed here.
+ *
+ * Notes: To register a new agent, #include its header below and add its
+ *        class to all_agents.
+ */
+
+#ifndef AGENTS_H
+#define AGENTS_H
+
+#include "../types.h" // agent_list
+
+#include "random_agent.h"
+#include "ordered_agent.h"
+#include "alphabeta_agent.h"
+#include "mcts_agent.h"
+
+// Include any additional agents here.
+
+
+typedef agent_list<random_agent::agent,
+		   ordered_agent::agent,
+		   alphabeta_agent::agent,
+		   mcts_agent::agent> all_agents;
+
+#endif
@@ -0,0 +1,174 @@
+/*
+ * File: alphabeta_agent.cpp
+ * Author: Joshua T. Guerin
+ * Description: A fixed-depth alpha-beta isola agent.  For details see
+ *              alphabeta_agent.h
+ */
+
+#include <cmath>  // lround()
+#include <vector> // Legal actions
+
+#include "alphabeta_agent.h"
+#include "../agent_abi.h" // ISOLA_EXPORT_AGENT
+#include "../symmetry.h"  // Symmetric root actions
+
+// Change namespace name to your lastname_firstname
+// Should be consistent with the namespace you select in your .h file.
+namespace alphabeta_agent {
+
+  // Can be hard-coded to any custom name for your agent.
+  const std::string agent::agent_name = "Alpha-Beta Agent";
+
+  unsigned agent::search_depth = 2;
+  const nnue_network* agent::network = 0;
+  std::string agent::weights_file;
+  bool agent::use_ordering = true;
+  
+  agent::agent(player c) : color(c), last_score(0), searched_nodes(0),
+			   table(table_size), use_network(false) {
+    // Now initialized: color value (white, black)
+    // A missing or unreadable file keeps the default weights.
+    if(!weights_file.empty())
+      weights.load(weights_file);
+
+    for(unsigned i=0; i<table_size; i++)
+      table[i].key = 0;
+  }
+
+  action agent::next_move(isola current_board) {
+    // The primary logic for your agent: selects the next move based on
+    // the current board state.
+    std::vector<action> actions = current_board.legal_actions(color);
+    player opponent = (color == black) ? white : black;
+    int alpha = -win_score - 1, beta = win_score + 1;
+    action best = actions.empty() ? action() : actions[0];
+    unsigned n = current_board.max_rows();
+    uint64_t hash = position_hash(current_board, color);
+    location from = current_board.find_player(color);
+
+    searched_nodes = 1;
+    order.new_search(n);
+
+    use_network = network != 0 &&
+      network->board_size == current_board.max_rows();
+    if(use_network)
+      accumulator.refresh(*network, current_board);
+
+    // If the board is symmetric (e.g., the start position), actions that
+    // a symmetry maps onto each other have the same value under the
+    // handcrafted evaluation, so only the first of each is searched.  (A
+    // network evaluation need not be symmetric.)
+    unsigned symmetries = use_network ? 1 : board_symmetries(current_board);
+
+    for(unsigned i=0; i<actions.size(); i++) {
+      if(symmetries != 1 && has_equivalent_before(actions, i, symmetries, n))
+	continue;
+
+      isola child = current_board;
+      child.move(color, actions[i].move_to, actions[i].remove);
+      uint64_t child_hash =
+	update_position_hash(hash, n, color, from, child.find_player(color),
+			     actions[i].remove);
+
+      if(use_network)
+	accumulator.move(current_board, color, actions[i]);
+      int value = -search(child, opponent, search_depth - 1, 1,
+			  -beta, -alpha, child_hash);
+      if(use_network)
+	accumulator.undo(current_board, color, actions[i]);
+
+      if(value > alpha) {
+	alpha = value;
+	best = actions[i];
+      }
+    }
+
+    last_score = alpha;
+    return best;
+  } // agent::next_move
+
+
+  int agent::search(isola& board, player to_move, unsigned depth,
+		    unsigned ply, int alpha, int beta, uint64_t hash) {
+    player opponent = (to_move == black) ? white : black;
+    searched_nodes++;
+
+    // The game ends as soon as either pawn is stuck.
+    switch(board.game_result()) {
+    case tied:
+      return 0;
+    case black_won:
+      return (to_move == black) ? win_score - ply : ply - win_score;
+    case white_won:
+      return (to_move == white) ? win_score - ply : ply - win_score;
+    case playing:
+      break;
+    }
+
+    if(depth == 0)
+      return evaluate(board, to_move);
+
+    std::vector<action> actions = board.legal_actions(to_move);
+    unsigned n = board.max_rows();
+    location from = board.find_player(to_move);
+    table_entry& entry = table[hash & (table_size - 1)];
+    if(use_ordering)
+      order.order(actions, ply, entry.key == hash ? &entry.move : 0);
+
+    for(unsigned i=0; i<actions.size(); i++) {
+      isola child = board;
+      child.move(to_move, actions[i].move_to, actions[i].remove);
+      uint64_t child_hash =
+	update_position_hash(hash, n, to_move, from,
+			     child.find_player(to_move), actions[i].remove);
+
+      if(use_network)
+	accumulator.move(board, to_move, actions[i]);
+      int value = -search(child, opponent, depth - 1, ply + 1,
+			  -beta, -alpha, child_hash);
+      if(use_network)
+	accumulator.undo(board, to_move, actions[i]);
+      if(value >= beta) {
+	if(use_ordering) {
+	  order.cutoff(actions[i], ply, depth);
+	  entry.key = hash;
+	  entry.move = actions[i];
+	}
+	return value;
+      }
+      if(value > alpha) {
+	alpha = value;
+	if(use_ordering) {
+	  entry.key = hash;
+	  entry.move = actions[i];
+	}
+      }
+    }
+
+    return alpha;
+  } // agent::search
+
+
+  int agent::evaluate(isola& board, player to_move) {
+    // A network's scores are only bounded by its weights.
+    long value;
+    if(use_network)
+      value = accumulator.evaluate(to_move);
+    else {
+      player opponent = (to_move == black) ? white : black;
+      isola_squares squares(board);
+      double features[num_features];
+      compute_features(squares, board.find_player(to_move),
+		       board.find_player(opponent), features, &weights);
+      value = lround(eval_scale * weights.evaluate(features));
+    }
+
+    return value > max_eval ? max_eval :
+      (value < -max_eval ? -max_eval : int(value));
+  } // agent::evaluate
+
+} // namespace
+
+
+// Exports this agent when compiled as a plugin (see agent_abi.h).
+ISOLA_EXPORT_AGENT(alphabeta_agent::agent)
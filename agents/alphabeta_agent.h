@@ -0,0 +1,138 @@
+/*
+ * File: alphabeta_agent.h
+ * Description: A search-based isola agent.  Looks ahead a fixed number of
+ *              plies with alpha-beta (negamax) search over every legal
+ *              action, and scores the leaves with the handcrafted
+ *              evaluation of evaluation.h (by default the difference in
+ *              mobility, i.e., legal pawn moves, between the two players).
+ *
+ * Notes: The search depth is shared by every instance (set_depth()).
+ *        Evaluation weights are read from the weights file (see
+ *        set_weights_file() and the tune binary) when an agent is
+ *        constructed.
+ *        If a network is set (set_network()) it replaces the mobility
+ *        evaluation, with its accumulator updated incrementally along the
+ *        search.
+ *        The score of the last search is available through score(), which
+ *        the self-play data generator records alongside each position.
+ *        Below the root, actions are searched in move_order.h's order
+ *        (the position's best action from a table of earlier searches,
+ *        then killers, then history), which cuts the nodes searched
+ *        without changing the result; the root keeps the generator's
+ *        order, so the move chosen among equal scores is unchanged.
+ *        set_move_ordering(false) restores the generator's order (to
+ *        measure the difference: see nodes()).
+ */
+
+#ifndef ALPHABETA_AGENT_H
+#define ALPHABETA_AGENT_H
+
+#include "../isola.h" // Game logic (required as a parameter to next_move)
+#include "../types.h" // Isola/tournament types.
+
+// Additional includes may be added here.
+#include <stdint.h>        // uint64_t
+#include <vector>          // Best move table
+#include "../evaluation.h" // Handcrafted evaluation
+#include "../move_order.h" // Killer/history ordering
+#include "../nnue.h"       // Optional network evaluation
+
+// Change namespace name to your lastname_firstname
+namespace alphabeta_agent {
+  class agent {
+  private:
+    player color; // Required
+
+    static unsigned search_depth;
+    static const nnue_network* network;
+    static std::string weights_file;
+    static bool use_ordering;
+
+    int last_score;
+    unsigned long long searched_nodes;
+    eval_weights weights;
+
+    // The best (or cutoff) action of positions searched, by
+    // position_hash(), for ordering when they come up again.
+    struct table_entry {
+      uint64_t key;
+      action move;
+    };
+    static const unsigned table_size = 1 << 15;
+    std::vector<table_entry> table;
+    move_order order;
+
+    // Network evaluation state for the node being searched.
+    bool use_network;
+    nnue_accumulator accumulator;
+
+    int search(isola& board, player to_move, unsigned depth, unsigned ply,
+	       int alpha, int beta, uint64_t hash);
+    /*
+     * Description: Negamax alpha-beta search.  Returns the value of board
+     *              (whose position_hash() is hash) from to_move's point of
+     *              view.
+     */
+
+    int evaluate(isola& board, player to_move);
+    /*
+     * Description: Weighted features (or network score) from
+     *              to_move's point of view, in 1/eval_scale units.
+     */
+    
+  public:
+    const static std::string agent_name; // Required
+    agent(player c); // Required
+    action next_move(isola current_board); // Required
+    std::string name() { return agent_name; } // Required
+
+    int score() { return last_score; }
+    /*
+     * Description: Value of the position searched by the last next_move()
+     *              call, from this agent's point of view.  Wins/losses are
+     *              +/-win_score (less the number of plies to reach them).
+     */
+
+    unsigned long long nodes() { return searched_nodes; }
+    /*
+     * Description: Positions visited by the last next_move() call (the
+     *              root, interior nodes and evaluated leaves).
+     */
+
+    static void set_depth(unsigned depth) {
+      // At least one ply is always searched.
+      search_depth = depth ? depth : 1;
+    }
+
+    static void set_network(const nnue_network* net) { network = net; }
+    /*
+     * Description: Evaluates with net (when its board size matches the
+     *              game) instead of mobility.  0 restores mobility.
+     */
+
+    static void set_weights_file(const std::string& filename) {
+      weights_file = filename;
+    }
+    /*
+     * Description: Agents constructed from now on load their evaluation
+     *              weights from filename.  An empty name (the default)
+     *              keeps the built-in mobility-only weights.
+     */
+
+    static void set_move_ordering(bool on) { use_ordering = on; }
+    /*
+     * Description: Turns move ordering below the root on (the default) or
+     *              off, for every instance.
+     */
+
+    static const int win_score = 10000;
+
+    // Evaluations are the weighted feature sum times eval_scale (or the
+    // network's score), clamped to +/-max_eval so they stay clear of win
+    // scores.
+    static const int eval_scale = 100;
+    static const int max_eval = win_score / 2;
+  };
+}
+
+#endif
@@ -0,0 +1,409 @@
+/*
+ * File: mcts_agent.cpp
+ * Author: Joshua T. Guerin
+ * Description: A Monte Carlo tree search isola agent.  For details see
+ *              mcts_agent.h
+ */
+
+#include <algorithm> // shuffle()
+#include <atomic>    // Shared statistics
+#include <cmath>     // log(), sqrt()
+#include <iostream>  // print_search_stats()
+#include <vector>    // Legal actions
+
+#include "mcts_agent.h"
+#include "../agent_abi.h" // ISOLA_EXPORT_AGENT
+#include "../seeds.h"     // agent_seed()
+
+// Change namespace name to your lastname_firstname
+// Should be consistent with the namespace you select in your .h file.
+namespace mcts_agent {
+
+  // Can be hard-coded to any custom name for your agent.
+  const std::string agent::agent_name = "MCTS Agent";
+
+  unsigned agent::num_iterations = 2000;
+  bool agent::factored = false;
+
+  // Exploration constant of UCB1.
+  static const double exploration = 1.4;
+
+  // Totals over every instance (agents may search on several threads).
+  static std::atomic<unsigned long long> total_searches(0);
+  static std::atomic<unsigned long long> reused_searches(0);
+  static std::atomic<unsigned long long> pondered_iterations(0);
+  static std::atomic<unsigned long long> total_nodes(0);
+  static std::atomic<unsigned long long> total_bytes(0);
+  static std::atomic<unsigned long long> peak_reserved(0);
+
+  static const direction directions[8] = {
+    north, south, east, west, northwest, northeast, southwest, southeast
+  };
+
+  static bool same_board(isola& a, isola& b) {
+    if(a.max_rows() != b.max_rows())
+      return false;
+    for(unsigned i=0; i<a.max_rows(); i++)
+      if(a[i] != b[i])
+	return false;
+    return true;
+  }
+
+  agent::agent(player c)
+    : color(c), nodes(0), reuse_root(0), rng(agent_seed()) {
+    // Now initialized: color value (white, black)
+    // Seeded from the game's seeds so that seeded tournaments replay
+    // exactly.
+  }
+
+  action agent::next_move(isola current_board) {
+    // The primary logic for your agent: selects the next move based on
+    // the current board state.
+
+    node* root = 0;
+    nodes = 0;
+    size_t start_bytes = tree.bytes_used();
+
+    // Continue the previous search if the opponent moved into its tree.
+    if(reuse_root != 0 && tree.bytes_used() < arena_limit &&
+       same_board(current_board, expected_board)) {
+      root = reuse_root;
+      reused_searches++;
+    }
+    else {
+      // The previous tree is released in O(1).
+      tree.reset();
+      start_bytes = 0;
+      root = tree.create<node>();
+      nodes = 1;
+    }
+    if(root->children == 0)
+      expand(root, current_board, color);
+
+    for(unsigned i=0; i<num_iterations; i++)
+      iterate(root, current_board, color);
+
+    node* best = most_visited(root);
+    action best_action;
+    if(is_direction(best)) {
+      // The most visited removal of the most visited direction.
+      isola half = current_board;
+      half.move_pawn(color, direction(best->move_to));
+      if(best->children == 0)
+	expand(best, half, color);
+      node* removal = most_visited(best);
+      best_action = action(direction(best->move_to),
+			   location(removal->remove_row, removal->remove_col));
+      best = removal;
+    }
+    else
+      best_action = unpack(best);
+
+    // Kept for the next move, if the opponent's reply is in the tree.
+    reuse_root = best;
+    expected_board = current_board;
+    expected_board.move(color, best_action.move_to, best_action.remove);
+
+    total_searches++;
+    total_nodes += nodes;
+    total_bytes += tree.bytes_used() - start_bytes;
+    unsigned long long reserved = tree.bytes_reserved();
+    unsigned long long peak = peak_reserved;
+    while(reserved > peak && !peak_reserved.compare_exchange_weak(peak,
+								  reserved))
+      ;
+
+    return best_action;
+  } // agent::next_move
+
+
+  void agent::ponder(isola board, const ponder_signal& signal) {
+    player opponent = (color == black) ? white : black;
+    unsigned long long iterations = 0;
+
+    // Only the subtree kept for the next move is worth growing.
+    if(reuse_root == 0 || !same_board(board, expected_board))
+      return;
+    if(reuse_root->children == 0)
+      expand(reuse_root, board, opponent);
+
+    while(!signal.stop_requested() && tree.bytes_used() < arena_limit) {
+      iterate(reuse_root, board, opponent);
+      iterations++;
+    }
+    pondered_iterations += iterations;
+  } // agent::ponder
+
+
+  void agent::opponent_moved(const action& a) {
+    node* reply = 0;
+    player opponent = (color == black) ? white : black;
+
+    if(reuse_root != 0)
+      for(unsigned i=0; i<reuse_root->num_children && reply == 0; i++) {
+	node* child = reuse_root->children + i;
+	if(child->move_to != a.move_to)
+	  continue;
+	if(!is_direction(child)) {
+	  if(child->remove_row == a.remove.row &&
+	     child->remove_col == a.remove.col)
+	    reply = child;
+	  continue;
+	}
+
+	// Factored: the removal below the direction.
+	for(unsigned j=0; j<child->num_children; j++) {
+	  node* removal = child->children + j;
+	  if(removal->remove_row == a.remove.row &&
+	     removal->remove_col == a.remove.col) {
+	    reply = removal;
+	    break;
+	  }
+	}
+      }
+
+    reuse_root = reply;
+    if(reply != 0)
+      expected_board.move(opponent, a.move_to, a.remove);
+  } // agent::opponent_moved
+
+
+  void agent::iterate(node* root, const isola& position, player to_move) {
+    isola board = position;
+    node* current = root;
+
+    path.clear();
+    path.push_back(root);
+
+    // Selection
+    while(current->children != 0) {
+      current = select_child(current);
+      apply(current, board, to_move);
+      path.push_back(current);
+    }
+
+    // A move stopped half way (at a direction node) is finished first: on
+    // the node's second visit by expanding its removals, else by a random
+    // removal outside the tree.
+    bool half_moved = is_direction(current);
+    if(half_moved && current->visits > 0) {
+      expand(current, board, to_move);
+      current = select_child(current);
+      apply(current, board, to_move);
+      path.push_back(current);
+      half_moved = false;
+    }
+    if(half_moved)
+      finish_move(board, to_move);
+
+    // Expansion (on the second visit) and simulation.  result is the
+    // value for to_move, the player to move at the leaf.
+    float result;
+    switch(board.game_result()) {
+    case tied:
+      result = 0.5;
+      break;
+    case black_won:
+      result = (to_move == black) ? 1 : 0;
+      break;
+    case white_won:
+      result = (to_move == white) ? 1 : 0;
+      break;
+    default:
+      if(current->visits > 0 && !is_direction(current)) {
+	expand(current, board, to_move);
+	current = select_child(current);
+	apply(current, board, to_move);
+	path.push_back(current);
+	if(is_direction(current))
+	  finish_move(board, to_move);
+      }
+      result = playout(board, to_move);
+      break;
+    }
+
+    // Backpropagation: each node is scored for the player who moved
+    // into it, alternating up the tree (except from a removal to its
+    // direction, both chosen by the same player).
+    float value = 1 - result;
+    for(size_t j=path.size(); j-- > 0;) {
+      path[j]->visits++;
+      path[j]->wins += value;
+      if(j == 0 || !is_direction(path[j-1]))
+	value = 1 - value;
+    }
+  } // agent::iterate
+
+
+  void agent::expand(node* n, isola& board, player to_move) {
+    // Factored trees: a (half-moved) direction node's removals are the
+    // open squares, the one just vacated included.
+    if(is_direction(n)) {
+      unsigned count = board.open_count();
+      n->children = tree.create_array<node>(count);
+      n->num_children = count;
+      nodes += count;
+      for(unsigned i=0; i<count; i++) {
+	node& child = n->children[i];
+	location square = board.open_square(i);
+	child.move_to = no_direction;
+	child.remove_row = square.row;
+	child.remove_col = square.col;
+      }
+      // open_square() order is arbitrary but not random.
+      std::shuffle(n->children, n->children + count, rng);
+      return;
+    }
+
+    unsigned mask = board.direction_mask(to_move);
+    location pawn = board.find_player(to_move);
+
+    if(factored) {
+      unsigned count = 0;
+      node* children = tree.create_array<node>(board.mobility(to_move));
+      for(unsigned d=0; d<8; d++)
+	if(mask & (1 << d)) {
+	  children[count].move_to = directions[d];
+	  children[count].remove_row = no_square;
+	  count++;
+	}
+      std::shuffle(children, children + count, rng);
+      n->children = children;
+      n->num_children = count;
+      nodes += count;
+      return;
+    }
+
+    // Same actions as board.legal_actions(), but into reused scratch
+    // space: each legal direction with every open square except the
+    // destination, or the square being vacated.
+    actions.clear();
+    for(unsigned d=0; d<8; d++) {
+      if(!(mask & (1 << d)))
+	continue;
+      location destination = board.new_location(to_move, directions[d]);
+      actions.push_back(action(directions[d], pawn));
+      for(unsigned i=0; i<board.open_count(); i++)
+	if(!(board.open_square(i) == destination))
+	  actions.push_back(action(directions[d], board.open_square(i)));
+    }
+    std::shuffle(actions.begin(), actions.end(), rng);
+
+    n->children = tree.create_array<node>(actions.size());
+    n->num_children = actions.size();
+    nodes += actions.size();
+
+    for(unsigned i=0; i<actions.size(); i++) {
+      node& child = n->children[i];
+      child.move_to = actions[i].move_to;
+      child.remove_row = actions[i].remove.row;
+      child.remove_col = actions[i].remove.col;
+    }
+  } // agent::expand
+
+
+  void agent::apply(const node* n, isola& board, player& to_move) {
+    if(is_direction(n)) {
+      board.move_pawn(to_move, direction(n->move_to));
+      return;
+    }
+
+    if(n->move_to == no_direction)
+      board.remove_square(location(n->remove_row, n->remove_col));
+    else
+      board.move(to_move, direction(n->move_to),
+		 location(n->remove_row, n->remove_col));
+    to_move = (to_move == black) ? white : black;
+  } // agent::apply
+
+
+  void agent::finish_move(isola& board, player& to_move) {
+    unsigned i =
+      std::uniform_int_distribution<unsigned>(0, board.open_count() - 1)(rng);
+    board.remove_square(board.open_square(i));
+    to_move = (to_move == black) ? white : black;
+  } // agent::finish_move
+
+
+  agent::node* agent::most_visited(node* n) {
+    node* best = n->children;
+    for(unsigned i=1; i<n->num_children; i++)
+      if(n->children[i].visits > best->visits)
+	best = n->children + i;
+    return best;
+  } // agent::most_visited
+
+
+  agent::node* agent::select_child(node* n) {
+    double log_visits = std::log(double(n->visits > 0 ? n->visits : 1));
+    node* best = n->children;
+    double best_value = -1;
+
+    for(unsigned i=0; i<n->num_children; i++) {
+      node* child = n->children + i;
+      // Children are in random order: the first unvisited one is as good
+      // as any.
+      if(child->visits == 0)
+	return child;
+
+      double value = child->wins / child->visits +
+	exploration * std::sqrt(log_visits / child->visits);
+      if(value > best_value) {
+	best_value = value;
+	best = child;
+      }
+    }
+
+    return best;
+  } // agent::select_child
+
+
+  float agent::playout(isola& board, player to_move) {
+    player start = to_move;
+
+    for(;;) {
+      switch(board.game_result()) {
+      case tied:
+	return 0.5;
+      case black_won:
+	return (start == black) ? 1 : 0;
+      case white_won:
+	return (start == white) ? 1 : 0;
+      case playing:
+	break;
+      }
+
+      action a = board.random_action(to_move, rng);
+      board.move(to_move, a.move_to, a.remove);
+      to_move = (to_move == black) ? white : black;
+    }
+  } // agent::playout
+
+
+  void agent::print_search_stats() {
+    if(total_searches == 0)
+      return;
+
+    std::cout << bold << "MCTS Agent: " << regular << total_searches
+	      << " searches (" << reused_searches << " reusing a subtree), "
+	      << total_nodes / total_searches
+	      << " new nodes and " << total_bytes / total_searches / 1024
+	      << " KiB of arena per search, peak arena "
+	      << peak_reserved / 1024 << " KiB";
+    if(pondered_iterations > 0)
+      std::cout << ", " << pondered_iterations / total_searches
+		<< " iterations pondered per search";
+    std::cout << std::endl;
+  } // agent::print_search_stats
+
+
+  // Reports the totals when the program (or plugin) is unloaded.
+  static struct search_stats_reporter {
+    ~search_stats_reporter() { agent::print_search_stats(); }
+  } reporter;
+
+} // namespace
+
+
+// Exports this agent when compiled as a plugin (see agent_abi.h).
+ISOLA_EXPORT_AGENT(mcts_agent::agent)
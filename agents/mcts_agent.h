@@ -0,0 +1,178 @@
+/*
+ * File: mcts_agent.h
+ * Description: A Monte Carlo tree search isola agent.  Grows a UCT search
+ *              tree for a fixed number of iterations, scoring new leaves
+ *              with a random playout, and plays the most visited action.
+ *
+ * Notes: Tree nodes and child arrays are allocated from an arena (see
+ *        arena.h) that is reset in O(1) at the start of every move, so
+ *        a search makes (almost) no calls to the system allocator.  A
+ *        node's children are created together, the second time the node
+ *        is visited.
+ *        The tree is kept between moves: when the opponent's move
+ *        (opponent_moved()) lands in the searched tree, the next search
+ *        starts from that subtree instead of from scratch.  The arena is
+ *        then only reset once it grows past arena_limit.
+ *        The iteration budget is shared by every instance
+ *        (set_iterations()).  Node counts and arena sizes are totalled
+ *        over all instances and printed at exit.
+ *        With set_factored(true) each move is two levels of the tree: a
+ *        node per legal direction, whose children are the removals after
+ *        that step (isola::move_pawn()/remove_square()).  A node has at
+ *        most 8 direction children instead of ~8n^2 action children, and
+ *        a direction's statistics gather every playout through any of its
+ *        removals, so good directions are found after far fewer
+ *        iterations.
+ */
+
+#ifndef MCTS_AGENT_H
+#define MCTS_AGENT_H
+
+#include <random> // Playouts
+#include <vector> // Scratch space
+
+#include "../isola.h" // Game logic (required as a parameter to next_move)
+#include "../types.h" // Isola/tournament types.
+
+// Additional includes may be added here.
+#include "../agent_traits.h" // ponder_signal
+#include "../arena.h"        // Search tree memory
+
+// Change namespace name to your lastname_firstname
+namespace mcts_agent {
+  class agent {
+  private:
+    player color; // Required
+
+    static unsigned num_iterations;
+    static bool factored;
+
+    struct node {
+      // Packed action leading to this node.  In a factored tree, a
+      // direction node has remove_row no_square, and its (removal)
+      // children have move_to no_direction.
+      unsigned char move_to, remove_row, remove_col;
+      unsigned num_children; // Up to 8*(n*n-2): over 65535 for n >= 91
+      unsigned visits;
+      float wins;     // For the player who made the move into this node
+      node* children; // Arena array, 0 until expanded
+    };
+
+    static const unsigned char no_direction = 0xff;
+    static const unsigned char no_square = 0xff;
+
+    arena tree;
+    unsigned long long nodes; // Nodes allocated by the last search
+
+    // Tree reuse: the subtree for the expected position, and that
+    // position (the last searched board, plus both moves since).
+    node* reuse_root;
+    isola expected_board;
+    std::mt19937 rng;
+
+    // Scratch space reused across iterations and moves.
+    std::vector<action> actions;
+    std::vector<node*> path;
+
+    void iterate(node* root, const isola& position, player to_move);
+    /*
+     * Description: One iteration (selection, expansion, playout,
+     *              backpropagation) from root, whose position is position
+     *              with to_move to move.
+     */
+
+    void expand(node* n, isola& board, player to_move);
+    /*
+     * Description: Creates n's children, one per legal action of
+     *              to_move, in random order.  Factored: one per legal
+     *              direction, or for a direction node (board then being
+     *              half-moved) one per legal removal.
+     */
+
+    void apply(const node* n, isola& board, player& to_move);
+    /*
+     * Description: Plays the action (or half of it) leading to n on
+     *              board.  Switches to_move once a whole move is played.
+     */
+
+    void finish_move(isola& board, player& to_move);
+    /*
+     * Description: Completes a half-moved board with a random removal
+     *              (outside the tree, as in a playout).
+     */
+
+    node* select_child(node* n);
+    /*
+     * Description: The child maximizing UCB1 (unvisited children first).
+     */
+
+    float playout(isola& board, player to_move);
+    /*
+     * Description: Plays random moves to the end of the game.
+     *
+     * Returns:
+     *     1 if to_move wins, 0 if it loses, 0.5 for a tie.
+     */
+
+    static node* most_visited(node* n);
+
+    static bool is_direction(const node* n) {
+      return n->remove_row == no_square;
+    }
+
+    static action unpack(const node* n) {
+      return action(direction(n->move_to),
+		    location(n->remove_row, n->remove_col));
+    }
+
+  public:
+    const static std::string agent_name; // Required
+    agent(player c); // Required
+    action next_move(isola current_board); // Required
+    std::string name() { return agent_name; } // Required
+
+    void opponent_moved(const action& a);
+    /*
+     * Description: Follows the opponent's move down the tree kept from
+     *              the last search (see agent_traits.h).
+     */
+
+    void ponder(isola board, const ponder_signal& signal);
+    /*
+     * Description: Keeps growing the tree kept from the last search while
+     *              the opponent thinks (see agent_traits.h), so the reply
+     *              lands in a subtree that has already been searched.
+     */
+
+    unsigned long long node_count() { return nodes; }
+    size_t arena_bytes() { return tree.bytes_used(); }
+    /*
+     * Description: Nodes allocated by the last search, and bytes held by
+     *              the tree (including subtrees kept from earlier moves).
+     */
+
+    // Trees kept between moves are dropped once the arena holds this
+    // many bytes.
+    static const size_t arena_limit = 64 << 20;
+
+    static void set_iterations(unsigned iterations) {
+      // At least one iteration is always run.
+      num_iterations = iterations ? iterations : 1;
+    }
+
+    static void set_factored(bool on) { factored = on; }
+    /*
+     * Description: Searches each move as a direction, then a removal
+     *              (see above), for every instance.  Off by default.
+     */
+
+    static void print_search_stats();
+    /*
+     * Description: Prints searches run, nodes allocated and arena memory,
+     *              totalled over every instance.  Prints nothing if no
+     *              searches were run.  Called automatically at exit.
+     */
+  };
+}
+
+#endif
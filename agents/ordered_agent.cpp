@@ -5,6 +5,7 @@
  */
 
 #include "ordered_agent.h"
+#include "../agent_abi.h" // ISOLA_EXPORT_AGENT
 
 // Change namespace name to your lastname_firstname
 // Should be consistent with the namespace you select in your .h file.
@@ -22,8 +23,8 @@ namespace ordered_agent {
   action agent::next_move(isola current_board) {
     // The primary logic for your agent: selects the next move based on
     // the current board state.
-    direction pawn_direction;
-    location current_location, to_remove;
+    direction pawn_direction = north;
+    location current_location, to_remove(0, 0);
     
     // Discover pawn's current location
     current_location = current_board.find_player(color);
@@ -55,25 +56,31 @@ namespace ordered_agent {
       pawn_direction = southeast;
     }
     
-    // Find the first square that is valid to remove, starting with 0,0
-    // Once found, return immediately
-    for(unsigned i=0; i<current_board.max_rows(); i++) {
-      for(unsigned j=0; j<current_board.max_cols(); j++) {
-	if(current_board.legal_move(color, pawn_direction, location(i, j))) {
-	  to_remove.row = i;
-	  to_remove.col = j;
+    // Find the first square that is valid to remove, starting with 0,0:
+    // the first open square other than the pawn's destination, or the
+    // square the pawn leaves if that comes first.  Removed squares are
+    // skipped without being visited, which matters on large boards.
+    unsigned size = current_board.max_rows();
+    unsigned own = current_location.row*size + current_location.col;
+    location destination = current_board.new_location(color, pawn_direction);
+    unsigned target = destination.row*size + destination.col;
+    const bitboard& open = current_board.open_squares();
 
-	  // Return found move
-	  return action(pawn_direction, to_remove);
-	}
-      }
-    }
+    unsigned first = open.first();
+    if(first == target)
+      first = open.next(first + 1);
+    if(own < first)
+      first = own;
 
-    // Final return to fulfill the compiler's demands.
-    // Should never get here.
+    to_remove.row = first / size;
+    to_remove.col = first % size;
     return action(pawn_direction, to_remove);
     
   } // agent::next_move
 
 
 } // namespace
+
+
+// Exports this agent when compiled as a plugin (see agent_abi.h).
+ISOLA_EXPORT_AGENT(ordered_agent::agent)
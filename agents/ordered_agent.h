@@ -21,12 +21,12 @@ namespace ordered_agent {
   class agent {
   private:
     player color; // Required
-    const static std::string agent_name; // Required
 
     // Additional helper methods can be declared here for internal
     // use as needed.
     
   public:
+    const static std::string agent_name; // Required
     agent(player c); // Required
     action next_move(isola current_board); // Required
     std::string name() { return agent_name; } // Required
@@ -25,16 +25,15 @@ namespace random_agent {
   class agent {
   private:
     player color; // Required
-    const static std::string agent_name; // Required
 
-    // Custom methods for the random agent (optional)
-    direction random_direction();
-    location random_location(int max_rows, int max_cols);
+    // Custom data for the random agent (optional)
+    std::mt19937 rng;
 
     // Additional helper methods can be declared here for internal
     // use as needed.
     
   public:
+    const static std::string agent_name; // Required
     agent(player c); // Required
     action next_move(isola current_board); // Required
     std::string name() {return agent_name; } // Required
@@ -0,0 +1,356 @@
+/*
+ * File: analyse.cpp
+ * Author: Joshua T. Guerin
+ * Purpose: Batch position analysis.
+ *          Reads positions (text, see isola::to_text(), one per line; or
+ *          binary, see isola::to_binary()) from a file or stdin, searches
+ *          each with the alpha-beta agent on every core, and writes one
+ *          line per position, in input order:
+ *              <position text> <tab> <best move> <tab> <score> <tab> <nodes>
+ *          The best move is "direction row col" (the removed square), or
+ *          "none" if the game is over; the score is the agent's, for the
+ *          side to move, and nodes the positions it visited.  The total
+ *          (e.g., over a fixed suite of positions, see suite.txt) measures
+ *          search efficiency at a given depth.
+ *
+ */
+
+
+#include <iostream>  // console io
+#include <chrono>    // Nodes/second
+#include <fstream>   // Input/output files
+#include <getopt.h>  // getopt()
+#include <cstdlib>   // atoi()
+#include <algorithm> // remove(), min()
+#include <sstream>   // Output lines
+#include <vector>    // Positions
+
+#include "isola.h"       // Game logic
+#include "thread_pool.h" // Parallel analysis
+#include "types.h"       // Types associated with game/tournament.
+
+#include "nnue.h"                   // Optional network evaluation
+#include "agents/alphabeta_agent.h" // The search agent
+
+using namespace std;
+
+// Analysis Flags
+unsigned search_depth=4;
+unsigned num_threads=0; // 0: one per hardware thread
+bool binary_input=false;
+bool move_ordering=true;
+string input_file, output_file;
+string network_file;
+string weights_file;
+
+// Positions read and searched at a time (bounds memory on long streams).
+const unsigned chunk_size=4096;
+
+struct position {
+  isola board;
+  player to_move;
+  string result; // The output line
+  unsigned long long nodes;
+};
+
+
+void parse_args(int argc, char *argv[]);
+/*
+ * Description: Parses command line arguments, sets associated flags.
+ */
+
+
+void help(string binary_name, string options);
+/*
+ * Description: Prints usage message if -h or --help flags arguments
+ *              are passed on the command line.
+ */
+
+
+bool read_positions(istream& in, vector<position>& positions,
+		    unsigned long long& line_number);
+/*
+ * Description: Reads up to chunk_size positions from in into positions.
+ *
+ * Returns:
+ *     false - a position could not be decoded (reported on cerr).
+ */
+
+
+void analyse(position* positions, unsigned count);
+/*
+ * Description: Searches each of count positions, filling in its result
+ *              line.  Each position is searched by its own agent.
+ */
+
+
+int main(int argc, char *argv[]) {
+  parse_args(argc, argv);
+
+  alphabeta_agent::agent::set_depth(search_depth);
+  alphabeta_agent::agent::set_move_ordering(move_ordering);
+
+  // Evaluate with a network instead of mobility.
+  nnue_network network;
+  if(!network_file.empty()) {
+    if(!network.load(network_file)) {
+      cerr << "Error: Could not load network " << network_file << "." << endl;
+      return 1;
+    }
+    alphabeta_agent::agent::set_network(&network);
+  }
+
+  // Tuned weights are read by each agent as it is constructed.
+  if(!weights_file.empty()) {
+    eval_weights weights;
+    if(!weights.load(weights_file)) {
+      cerr << "Error: Could not load weights " << weights_file << "." << endl;
+      return 1;
+    }
+    alphabeta_agent::agent::set_weights_file(weights_file);
+  }
+
+  ifstream in_file;
+  ios::openmode mode = binary_input ? ios::in | ios::binary : ios::in;
+  if(!input_file.empty() && input_file != "-") {
+    in_file.open(input_file.c_str(), mode);
+    if(!in_file) {
+      cerr << "Error: Could not open " << input_file << "." << endl;
+      return 1;
+    }
+  }
+  istream& in = in_file.is_open() ? in_file : cin;
+
+  ofstream out_file;
+  if(!output_file.empty() && output_file != "-") {
+    out_file.open(output_file.c_str());
+    if(!out_file) {
+      cerr << "Error: Could not create " << output_file << "." << endl;
+      return 1;
+    }
+  }
+  ostream& out = out_file.is_open() ? out_file : cout;
+
+  thread_pool pool(num_threads ? num_threads :
+		   thread_pool::default_threads());
+  vector<position> positions;
+  unsigned long long line_number = 0, analysed = 0, nodes = 0;
+  bool valid = true;
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+  while(valid) {
+    valid = read_positions(in, positions, line_number);
+    if(positions.empty())
+      break;
+
+    // A few slices per thread, so that slow positions even out.
+    unsigned slice = max(1u, unsigned(positions.size() / (4 * pool.size())));
+    for(unsigned first=0; first<positions.size(); first+=slice) {
+      unsigned count = min(slice, unsigned(positions.size()) - first);
+      pool.submit([&positions, first, count]() {
+	  analyse(&positions[first], count);
+	});
+    }
+    pool.wait();
+
+    for(unsigned i=0; i<positions.size(); i++) {
+      out << positions[i].result << '\n';
+      nodes += positions[i].nodes;
+    }
+    out.flush();
+    analysed += positions.size();
+  }
+
+  double seconds = chrono::duration<double>(chrono::steady_clock::now() -
+					    start).count();
+  cerr << "Analysed " << analysed << " positions: " << nodes << " nodes ("
+       << nodes / seconds << " nodes/s)." << endl;
+  return valid ? 0 : 1;
+}
+
+
+bool read_positions(istream& in, vector<position>& positions,
+		    unsigned long long& line_number) {
+  positions.clear();
+
+  while(positions.size() < chunk_size) {
+    position p;
+
+    if(binary_input) {
+      // The board size comes first, and fixes the length.
+      unsigned char data[2 + 4 + 255*255/8 + 1];
+      int n = in.get();
+      if(n == EOF)
+	break;
+      data[0] = n;
+      line_number++;
+      unsigned length = isola::binary_size(n);
+      if(n < 2 || !in.read((char*)data + 1, length - 1) ||
+	 isola::from_binary(data, length, p.board, p.to_move) == 0) {
+	cerr << "Error: Position " << line_number << " is not valid." << endl;
+	return false;
+      }
+    }
+    else {
+      string line;
+      if(!getline(in, line))
+	break;
+      line_number++;
+
+      // Blank lines and comments are skipped.
+      size_t start = line.find_first_not_of(" \t\r");
+      if(start == string::npos || line[start] == '#')
+	continue;
+      if(!isola::from_text(line.substr(start), p.board, p.to_move)) {
+	cerr << "Error: Line " << line_number << " is not a valid position: "
+	     << line << endl;
+	return false;
+      }
+    }
+
+    positions.push_back(p);
+  }
+  return true;
+}
+
+
+void analyse(position* positions, unsigned count) {
+  for(unsigned i=0; i<count; i++) {
+    position& p = positions[i];
+    ostringstream line;
+    line << p.board.to_text(p.to_move) << '\t';
+    p.nodes = 0;
+
+    game_outcome result = p.board.game_result();
+    if(result == playing) {
+      // A fresh agent: no history or table from other positions, so the
+      // result does not depend on -j or on how positions are split up.
+      alphabeta_agent::agent agent(p.to_move);
+      action best = agent.next_move(p.board);
+      p.nodes = agent.nodes();
+      line << direction_names[best.move_to] << ' ' << best.remove.row << ' '
+	   << best.remove.col << '\t' << agent.score();
+    }
+    else {
+      // Scored as the search scores a finished game.
+      int score = 0;
+      if(result == black_won)
+	score = alphabeta_agent::agent::win_score;
+      else if(result == white_won)
+	score = -alphabeta_agent::agent::win_score;
+      line << "none\t" << (p.to_move == black ? score : -score);
+    }
+    line << '\t' << p.nodes;
+
+    p.result = line.str();
+  }
+}
+
+
+void parse_args(int argc, char *argv[]) {
+  int option;
+  opterr = 0;
+
+  // getopt_long arguments
+  string options = "bd:f:hj:o:";
+  const struct option long_options[] =
+    {
+      {"binary",      no_argument,        0, 'b'},
+      {"depth",       required_argument,  0, 'd'},
+      {"file",        required_argument,  0, 'f'},
+      {"help",        no_argument,        0, 'h'},
+      {"threads",     required_argument,  0, 'j'},
+      {"output",      required_argument,  0, 'o'},
+      {"no-ordering", no_argument,        0, 'U'},
+      {"network",     required_argument,  0, 'N'},
+      {"weights",     required_argument,  0, 'E'},
+      {0,0,0,0},
+    };
+  int option_index;
+
+  option = getopt_long(argc, argv, options.c_str(),
+		       long_options, &option_index);
+
+  while(option != -1) {
+    switch(option) {
+    case 'b':
+      // Binary positions
+      binary_input = true;
+      break;
+    case 'd':
+      // Search depth of the agent
+      search_depth = atoi(optarg);
+      break;
+    case 'f':
+      // Input file
+      input_file = optarg;
+      break;
+    case 'h':
+      // Help flag
+      help(argv[0], options);
+      exit(0);
+      break;
+    case 'j':
+      // Number of worker threads
+      num_threads = atoi(optarg);
+      break;
+    case 'o':
+      // Output file
+      output_file = optarg;
+      break;
+    case 'U':
+      // Generator order below the root (long option only)
+      move_ordering = false;
+      break;
+    case 'N':
+      // Network evaluation (long option only)
+      network_file = optarg;
+      break;
+    case 'E':
+      // Evaluation weights (long option only)
+      weights_file = optarg;
+      break;
+    case '?':
+      cerr << "Error: Unrecognized argument or missing value." << endl
+	   << "See the -h option for usage." << endl;
+      exit(0);
+      break;
+    default:
+      cerr << "Error: Unknown argument: " << char(option) << endl;
+      exit(0);
+      break;
+    }
+
+    option = getopt_long(argc, argv, options.c_str(),
+			 long_options, &option_index);
+  }
+}
+
+
+void help(string binary_name, string options) {
+  options.erase(remove(options.begin(), options.end(), ':'), options.end());
+
+  cout << bold << "NAME\n\t" << binary_name << regular << " -- searches a stream of isola positions" << endl
+       << bold << "SYNOPSIS: \n\t" << binary_name
+       << " [-" << options << "]" << regular << endl
+       << bold << "OPTIONS:" << regular << endl
+       << bold << "-b | --binary" << regular
+       << "         Positions are binary (isola::to_binary()), not text." << endl
+       << bold << "-d | --depth n" << regular
+       << "        Search depth of the alpha-beta agent (default: 4)." << endl
+       << bold << "-f | --file name" << regular
+       << "      Reads positions from " << bold << "name" << regular << " (default: stdin)." << endl
+       << bold << "-h | --help" << regular
+       << "           Print this help." << endl
+       << bold << "-j | --threads n" << regular
+       << "      Uses " << bold << 'n' << regular << " worker threads (default: all hardware threads)." << endl
+       << bold << "-o | --output name" << regular
+       << "    Writes results to " << bold << "name" << regular << " (default: stdout)." << endl
+       << bold << "--no-ordering" << regular
+       << "         Searches in the move generator's order (no killer," << endl
+       << "                      history or table moves), for comparison." << endl
+       << bold << "--network file" << regular
+       << "        Evaluates with the network in " << bold << "file" << regular << " instead of mobility." << endl
+       << bold << "--weights file" << regular
+       << "        Evaluates with the weights in " << bold << "file" << regular << " (see tune)." << endl;
+}
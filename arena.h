@@ -0,0 +1,129 @@
+/*
+ * File: arena.h
+ * Author: Joshua T. Guerin
+ * Purpose: A bump allocator for search trees.  Tree-search agents
+ *          allocate many small nodes and child arrays during a search and
+ *          discard all of them together afterwards; an arena hands out
+ *          memory from large blocks and frees everything at once.
+ *
+ * Note: Only trivially destructible objects may be stored (no
+ *       destructors are run).  reset() keeps the blocks for reuse, so a
+ *       long-lived arena stops calling the system allocator once it has
+ *       grown to the size of the largest search.
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>     // size_t
+#include <memory>      // unique_ptr for blocks
+#include <new>         // Placement new
+#include <type_traits> // is_trivially_destructible
+#include <vector>      // Block list
+
+
+class arena {
+  /*
+   * Description: Allocates objects from a list of blocks, in order.
+   */
+ private:
+  struct block {
+    std::unique_ptr<char[]> memory;
+    size_t size;
+  };
+
+  std::vector<block> blocks;
+  size_t block_size;
+  size_t current;    // Block being allocated from
+  size_t offset;     // Bytes used in the current block
+  size_t used;       // Bytes handed out since the last reset (with padding)
+
+  void next_block(size_t bytes) {
+    /*
+     * Description: Moves to the next block with room for bytes, adding a
+     *              block if no later block is large enough.
+     */
+    if(!blocks.empty())
+      current++;
+    while(current < blocks.size() && blocks[current].size < bytes)
+      current++;
+
+    if(current >= blocks.size()) {
+      block b;
+      b.size = bytes > block_size ? bytes : block_size;
+      b.memory.reset(new char[b.size]);
+      current = blocks.size();
+      blocks.push_back(std::move(b));
+    }
+    offset = 0;
+  }
+
+ public:
+  explicit arena(size_t block_bytes = 1 << 20)
+    : block_size(block_bytes), current(0), offset(0), used(0) {}
+
+  arena(const arena&) = delete;
+  arena& operator=(const arena&) = delete;
+
+  void* allocate(size_t bytes, size_t alignment) {
+    /*
+     * Description: Returns bytes of uninitialized memory aligned to
+     *              alignment (a power of two).
+     */
+    size_t start = (offset + alignment - 1) & ~(alignment - 1);
+
+    if(blocks.empty() || start + bytes > blocks[current].size) {
+      next_block(bytes + alignment);
+      start = (size_t(blocks[current].memory.get()) + alignment - 1) &
+	~(alignment - 1);
+      start -= size_t(blocks[current].memory.get());
+    }
+
+    used += start + bytes - offset;
+    offset = start + bytes;
+    return blocks[current].memory.get() + start;
+  }
+
+  template <typename T>
+  T* create_array(size_t count) {
+    /*
+     * Description: Allocates count default-constructed Ts.
+     */
+    static_assert(std::is_trivially_destructible<T>::value,
+		  "arena objects are never destroyed");
+    T* items = static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+    for(size_t i=0; i<count; i++)
+      new (items + i) T();
+    return items;
+  }
+
+  template <typename T>
+  T* create() { return create_array<T>(1); }
+
+  void reset() {
+    /*
+     * Description: Frees every object at once.  O(1): the blocks are kept
+     *              and allocation restarts at the first one.
+     */
+    current = 0;
+    offset = 0;
+    used = 0;
+  }
+
+  size_t bytes_used() const { return used; }
+  /*
+   * Description: Bytes handed out since the last reset.
+   */
+
+  size_t bytes_reserved() const {
+    /*
+     * Description: Bytes held in blocks (the arena's memory footprint).
+     */
+    size_t total = 0;
+    for(size_t i=0; i<blocks.size(); i++)
+      total += blocks[i].size;
+    return total;
+  }
+};
+
+#endif
@@ -0,0 +1,626 @@
+/*
+ * File: batch.h
+ * Author: Joshua T. Guerin
+ * Purpose: Plays many independent isola games in lockstep, for bulk
+ *          statistics and data from simple agents.  Game state is stored
+ *          as a structure of arrays (one entry per game: removed-square
+ *          bitboard, pawn bitboards, side to move), so each step of the
+ *          engine runs the same short loop over every game: legal moves
+ *          for all games at once, then one batch of moves per policy,
+ *          then all of the moves applied.
+ *
+ * Policies: A policy plays one side of every game in a batch.  It is
+ *           constructed with the number of games and provides
+ *               void start(unsigned game, player color, game_seeds& seeds);
+ *           (called as each game is set up, in the same order that
+ *           tournament constructs its agents; seeds() returns what
+ *           agent_seed() would return to those agents) and
+ *               void choose(const game_batch& games, const unsigned* moving,
+ *                           unsigned count, batch_move* moves);
+ *           which fills moves[i] for game moving[i], for every game in
+ *           which the policy is to move.  Moves must be legal (illegal
+ *           ones are counted and skipped).
+ *
+ * Notes: Each game is set up exactly as tournament::run_simulation(seed,
+ *        swap_colors) sets it up (first mover, opening, agent seeds), so
+ *        a policy that decides like an agent (e.g., random_policy,
+ *        ordered_policy) gives the same outcome for every game.
+ *        Boards are at most 8x8 (one 64-bit word per bitboard).
+ *        This is a templated class (template parameters are policies).  As
+ *        such there is no batch.cpp; batchplay.cpp is the driver.
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <mutex>    // Totals
+#include <random>   // uniform_int_distribution
+#include <stdint.h> // uint64_t
+#include <vector>   // Game state
+
+#include "types.h"                  // Isola/tournament types.
+#include "agents/ordered_agent.h"   // Agents reproduced by the policies
+#include "agents/random_agent.h"
+
+
+class lazy_mt19937 {
+  /*
+   * Description: Produces exactly the numbers std::mt19937 does for the
+   *              same seed, but seeds and twists its state one word at a
+   *              time as outputs need them.  A batched game draws only a
+   *              few dozen numbers, so this costs a few hundred steps
+   *              where std::mt19937 spends 1248 (seeding and the first
+   *              twist) before its first output.
+   */
+ private:
+  static const unsigned n = 624, m = 397;
+  uint32_t state[n];
+  unsigned seeded; // state[0 ... seeded-1] are initialized.
+  unsigned index;  // Next word to twist and output.
+
+ public:
+  typedef std::uint_fast32_t result_type;
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() { return 0xffffffff; }
+
+  lazy_mt19937() { seed(5489); }
+
+  void seed(result_type s) {
+    state[0] = s;
+    seeded = 1;
+    index = 0;
+  }
+
+  result_type operator()() {
+    if(index == n)
+      index = 0;
+
+    // Twisting word i in place reads the old words i, i+1 and i+m (mod
+    // n), so only those must be seeded so far.
+    unsigned needed = index < n - m ? index + m + 1 : index + 2;
+    for(; seeded < needed && seeded < n; seeded++)
+      state[seeded] = 1812433253u * (state[seeded - 1] ^
+				     (state[seeded - 1] >> 30)) + seeded;
+
+    uint32_t y = (state[index] & 0x80000000u) |
+      (state[(index + 1) % n] & 0x7fffffffu);
+    state[index] = state[(index + m) % n] ^ (y >> 1) ^
+      ((y & 1) ? 0x9908b0dfu : 0);
+
+    // Tempering
+    y = state[index++];
+    y ^= y >> 11;
+    y ^= (y << 7) & 0x9d2c5680u;
+    y ^= (y << 15) & 0xefc60000u;
+    return y ^ (y >> 18);
+  }
+};
+
+
+class game_seeds {
+  /*
+   * Description: agent_seed() (see seeds.h) as agents constructed by
+   *              tournament::run_simulation(seed) see it.
+   */
+ private:
+  lazy_mt19937 seeds;
+
+ public:
+  explicit game_seeds(unsigned s) { seeds.seed(s); }
+
+  unsigned operator()() { return seeds(); }
+};
+
+
+struct batch_move {
+  /*
+   * A move in a batched game: move_to is a direction, remove a square
+   * (row*n + col).
+   */
+  unsigned char move_to;
+  unsigned char remove;
+};
+
+
+struct batch_game {
+  /*
+   * The seed and colors of one game, as for
+   * tournament::run_simulation(seed, swap_colors).
+   */
+  unsigned seed;
+  bool swap_colors;
+};
+
+
+class game_batch {
+  /*
+   * Description: The state of many games, as a structure of arrays
+   *              indexed by game.  Squares are numbered row*n + col, bit s
+   *              of a bitboard being square s.
+   *
+   * Notes: Each game also keeps its open squares in the same unordered
+   *        list as isola (same order, same swap-removal), so policies can
+   *        draw the same random squares as agents do.
+   */
+ public:
+  static const unsigned max_size = 8;
+
+  unsigned board_size;
+  unsigned num_games;
+  uint64_t board_mask;
+
+  std::vector<uint64_t> removed;
+  std::vector<uint64_t> black_pawn, white_pawn;
+  std::vector<unsigned char> white_to_move;
+
+  // Legal directions of each pawn (bit d: direction d), set by
+  // update_moves().
+  std::vector<unsigned char> black_moves, white_moves;
+
+  // Open squares: open_list[game*64 + i] for i < open_size[game].
+  std::vector<unsigned char> open_list, open_position, open_size;
+
+  game_batch(unsigned n, unsigned games);
+
+  void reset(unsigned game, player to_move);
+  /*
+   * Description: Sets game to the start position (as isola(n)), to_move
+   *              to move.
+   */
+
+  void update_moves(const unsigned* games, unsigned count);
+  /*
+   * Description: Recomputes both pawns' legal directions in games[0 ...
+   *              count-1] (one branch-free pass), skipping the games that
+   *              have already finished.
+   */
+
+  void update_moves(unsigned game);
+  /*
+   * Description: Recomputes both pawns' legal directions in one game.
+   */
+
+  game_outcome result(unsigned game) const;
+  /*
+   * Description: As isola::game_result(), from the last update_moves().
+   */
+
+  player to_move(unsigned game) const {
+    return white_to_move[game] ? white : black;
+  }
+
+  unsigned char direction_mask(unsigned game, player p) const {
+    return p == black ? black_moves[game] : white_moves[game];
+  }
+
+  uint64_t pawn(unsigned game, player p) const {
+    return p == black ? black_pawn[game] : white_pawn[game];
+  }
+
+  uint64_t open(unsigned game) const {
+    return board_mask & ~(removed[game] | black_pawn[game] | white_pawn[game]);
+  }
+
+  uint64_t step(uint64_t squares, unsigned d) const;
+  /*
+   * Description: squares moved one step in direction d (squares that
+   *              would leave the board are dropped).
+   */
+
+  template <typename TRng>
+  batch_move random_move(unsigned game, player p, TRng& rng) const;
+  /*
+   * Description: Draws p's move exactly as isola::random_action() would
+   *              on the same board with the same generator state.
+   *
+   * Preconditions: p has a legal move (after update_moves()).
+   */
+
+  bool move(unsigned game, batch_move m);
+  /*
+   * Description: Applies m for the side to move and passes the turn.
+   *
+   * Returns:
+   *     false - m is illegal (nothing is applied, but the turn passes).
+   */
+
+ private:
+  uint64_t first_col, last_col;
+
+  static unsigned moves_from(uint64_t pawn, uint64_t free, unsigned n,
+			     uint64_t west_ok, uint64_t east_ok);
+  /*
+   * Description: The directions in which pawn can step onto free squares
+   *              (west_ok/east_ok: squares not in the first/last column).
+   */
+
+  void add_open(unsigned game, unsigned square);
+  void remove_open(unsigned game, unsigned square);
+};
+
+
+template <typename TBlackPolicy, typename TWhitePolicy>
+class batch_tournament {
+  /*
+   * Batched tournament class: Plays batches of games between policies
+   *                           TBlackPolicy and TWhitePolicy (TBlackPolicy
+   *                           plays black unless a game swaps colors).
+   */
+ private:
+  unsigned board_size;
+  unsigned opening_plies;
+
+  unsigned long long total_plies;
+  unsigned long long illegal_moves;
+
+  void set_up(game_batch& games, unsigned game, const batch_game& spec,
+	      TBlackPolicy& policy_a, TWhitePolicy& policy_b,
+	      std::vector<player>& a_color);
+  /*
+   * Description: Sets up one game as tournament::run_simulation() would.
+   */
+
+ public:
+  batch_tournament(unsigned grid_size, unsigned plies);
+  /*
+   * Description: Games on grid_size x grid_size boards (at most 8x8)
+   *              starting with plies random legal moves.
+   */
+
+  void play(const batch_game* games, unsigned count, round_winner* results);
+  /*
+   * Description: Plays count games in lockstep; results[i] is the
+   *              winner of games[i] by pawn color.
+   *
+   * Notes: Safe to call from several threads at once (each call has its
+   *        own batch and policies).
+   */
+
+  unsigned long long plies() const { return total_plies; }
+  /*
+   * Description: Moves made by the policies over all play() calls.
+   */
+
+  unsigned long long illegal() const { return illegal_moves; }
+  /*
+   * Description: Illegal (skipped) policy moves over all play() calls.
+   */
+};
+
+
+class random_policy {
+  /*
+   * Description: Uniformly random legal moves, drawn exactly as
+   *              random_agent::agent draws them.
+   */
+ private:
+  std::vector<lazy_mt19937> rng;
+  std::vector<player> color;
+
+ public:
+  typedef random_agent::agent reference_agent;
+
+  explicit random_policy(unsigned games) : rng(games), color(games) {}
+
+  void start(unsigned game, player c, game_seeds& seeds) {
+    // random_agent seeds from agent_seed() when constructed.
+    color[game] = c;
+    rng[game].seed(seeds());
+  }
+
+  void choose(const game_batch& games, const unsigned* moving, unsigned count,
+	      batch_move* moves) {
+    for(unsigned i=0; i<count; i++) {
+      unsigned g = moving[i];
+      moves[i] = games.random_move(g, color[g], rng[g]);
+    }
+  }
+};
+
+
+class ordered_policy {
+  /*
+   * Description: The first legal direction in the order N, W, E, S, NW,
+   *              NE, SW, SE, removing the first removable square in
+   *              row-major order, as ordered_agent::agent does.
+   */
+ private:
+  std::vector<player> color;
+
+ public:
+  typedef ordered_agent::agent reference_agent;
+
+  explicit ordered_policy(unsigned games) : color(games) {}
+
+  void start(unsigned game, player c, game_seeds&) { color[game] = c; }
+
+  void choose(const game_batch& games, const unsigned* moving, unsigned count,
+	      batch_move* moves) {
+    static const direction order[8] = {
+      north, west, east, south, northwest, northeast, southwest, southeast
+    };
+
+    for(unsigned i=0; i<count; i++) {
+      unsigned g = moving[i];
+      unsigned mask = games.direction_mask(g, color[g]);
+      unsigned d = north;
+      for(unsigned j=8; j-- > 0;)
+	if(mask & (1 << order[j]))
+	  d = order[j];
+
+      uint64_t pawn = games.pawn(g, color[g]);
+      uint64_t removable = games.open(g) & ~games.step(pawn, d);
+      unsigned own = __builtin_ctzll(pawn);
+      unsigned first = removable ? __builtin_ctzll(removable) : 64;
+
+      moves[i].move_to = d;
+      moves[i].remove = first < own ? first : own;
+    }
+  }
+};
+
+
+inline game_batch::game_batch(unsigned n, unsigned games)
+  : board_size(n), num_games(games), removed(games), black_pawn(games),
+    white_pawn(games), white_to_move(games), black_moves(games),
+    white_moves(games), open_list(games * 64), open_position(games * 64),
+    open_size(games) {
+  board_mask = n * n == 64 ? ~uint64_t(0) : (uint64_t(1) << (n * n)) - 1;
+
+  first_col = last_col = 0;
+  for(unsigned i=0; i<n; i++) {
+    first_col |= uint64_t(1) << (i * n);
+    last_col |= uint64_t(1) << (i * n + n - 1);
+  }
+}
+
+
+inline void game_batch::reset(unsigned game, player to_move) {
+  unsigned n = board_size;
+  unsigned b = n / 2, w = (n - 1) * n + n / 2;
+
+  removed[game] = 0;
+  black_pawn[game] = uint64_t(1) << b;
+  white_pawn[game] = uint64_t(1) << w;
+  white_to_move[game] = to_move == white;
+
+  // Row-major, as isola builds its open square list.
+  open_size[game] = 0;
+  for(unsigned square=0; square<n*n; square++)
+    if(square != b && square != w)
+      add_open(game, square);
+}
+
+
+inline uint64_t game_batch::step(uint64_t squares, unsigned d) const {
+  unsigned n = board_size;
+
+  switch(d) {
+  case north:
+    return squares >> n;
+  case south:
+    return (squares << n) & board_mask;
+  case east:
+    return (squares & ~last_col) << 1;
+  case west:
+    return (squares & ~first_col) >> 1;
+  case northwest:
+    return (squares & ~first_col) >> (n + 1);
+  case northeast:
+    return (squares & ~last_col) >> (n - 1);
+  case southwest:
+    return ((squares & ~first_col) << (n - 1)) & board_mask;
+  case southeast:
+    return ((squares & ~last_col) << (n + 1)) & board_mask;
+  }
+  return 0;
+}
+
+
+inline unsigned game_batch::moves_from(uint64_t p, uint64_t free, unsigned n, uint64_t west_ok, uint64_t east_ok) {
+  // Branch-free, so that loops over games can be vectorized.
+  return
+    unsigned(((p >> n) & free) != 0) << north |
+    unsigned(((p << n) & free) != 0) << south |
+    unsigned((((p & east_ok) << 1) & free) != 0) << east |
+    unsigned((((p & west_ok) >> 1) & free) != 0) << west |
+    unsigned((((p & west_ok) >> (n + 1)) & free) != 0) << northwest |
+    unsigned((((p & east_ok) >> (n - 1)) & free) != 0) << northeast |
+    unsigned((((p & west_ok) << (n - 1)) & free) != 0) << southwest |
+    unsigned((((p & east_ok) << (n + 1)) & free) != 0) << southeast;
+}
+
+
+inline void game_batch::update_moves(const unsigned* games, unsigned count) {
+  // Plain loops over the listed games, without branches.  Every member
+  // used is copied first: the stores through unsigned char pointers could
+  // otherwise alias them.
+  const unsigned n = board_size;
+  const uint64_t inside = board_mask;
+  const uint64_t west_ok = ~first_col, east_ok = ~last_col;
+  const uint64_t* r = removed.data();
+  const uint64_t* bp = black_pawn.data();
+  const uint64_t* wp = white_pawn.data();
+  unsigned char* bm = black_moves.data();
+  unsigned char* wm = white_moves.data();
+
+  for(unsigned i=0; i<count; i++) {
+    unsigned g = games[i];
+    uint64_t free = inside & ~(r[g] | bp[g] | wp[g]);
+    bm[g] = moves_from(bp[g], free, n, west_ok, east_ok);
+    wm[g] = moves_from(wp[g], free, n, west_ok, east_ok);
+  }
+}
+
+
+inline void game_batch::update_moves(unsigned game) {
+  black_moves[game] = moves_from(black_pawn[game], open(game), board_size,
+				 ~first_col, ~last_col);
+  white_moves[game] = moves_from(white_pawn[game], open(game), board_size,
+				 ~first_col, ~last_col);
+}
+
+
+template <typename TRng>
+batch_move game_batch::random_move(unsigned game, player p, TRng& rng) const {
+  unsigned mask = direction_mask(game, p);
+  batch_move m;
+
+  // The k-th legal direction, then a uniform open square (the destination
+  // standing for the square being vacated).
+  unsigned k = std::uniform_int_distribution<unsigned>(
+    0, __builtin_popcount(mask) - 1)(rng);
+  for(; k>0; k--)
+    mask &= mask - 1;
+  m.move_to = __builtin_ctz(mask);
+
+  uint64_t from = pawn(game, p);
+  unsigned r = std::uniform_int_distribution<unsigned>(
+    0, open_size[game] - 1)(rng);
+  m.remove = open_list[game*64 + r];
+  if(m.remove == __builtin_ctzll(step(from, m.move_to)))
+    m.remove = __builtin_ctzll(from);
+  return m;
+}
+
+
+inline game_outcome game_batch::result(unsigned game) const {
+  if(black_moves[game] == 0 && white_moves[game] == 0)
+    return tied;
+  if(black_moves[game] == 0)
+    return white_won;
+  if(white_moves[game] == 0)
+    return black_won;
+  return playing;
+}
+
+
+inline bool game_batch::move(unsigned game, batch_move m) {
+  player p = to_move(game);
+  uint64_t& pawn = p == black ? black_pawn[game] : white_pawn[game];
+  uint64_t target = step(pawn, m.move_to);
+  uint64_t remove = uint64_t(1) << m.remove;
+  bool legal = m.move_to < 8 && (direction_mask(game, p) >> m.move_to & 1) &&
+    m.remove < 64 && (remove & (open(game) | pawn) & ~target) != 0;
+
+  white_to_move[game] = !white_to_move[game];
+  if(!legal)
+    return false;
+
+  // Same order as isola::move(), which keeps the open lists identical.
+  unsigned from = __builtin_ctzll(pawn);
+  pawn = target;
+  add_open(game, from);
+  remove_open(game, __builtin_ctzll(target));
+  removed[game] |= remove;
+  remove_open(game, m.remove);
+  return true;
+}
+
+
+inline void game_batch::add_open(unsigned game, unsigned square) {
+  unsigned char* list = &open_list[game * 64];
+  open_position[game * 64 + square] = open_size[game];
+  list[open_size[game]++] = square;
+}
+
+
+inline void game_batch::remove_open(unsigned game, unsigned square) {
+  // Swap the last square into the removed one's place.
+  unsigned char* list = &open_list[game * 64];
+  unsigned char* position = &open_position[game * 64];
+  unsigned last = list[--open_size[game]];
+  list[position[square]] = last;
+  position[last] = position[square];
+}
+
+
+template <typename TBlackPolicy, typename TWhitePolicy>
+batch_tournament<TBlackPolicy, TWhitePolicy>::batch_tournament(unsigned grid_size, unsigned plies) {
+  board_size = grid_size;
+  opening_plies = plies;
+  total_plies = 0;
+  illegal_moves = 0;
+}
+
+template <typename TBlackPolicy, typename TWhitePolicy>
+void batch_tournament<TBlackPolicy, TWhitePolicy>::set_up(game_batch& games, unsigned game, const batch_game& spec, TBlackPolicy& policy_a, TWhitePolicy& policy_b, std::vector<player>& a_color) {
+  lazy_mt19937 rng;
+  rng.seed(spec.seed);
+  player current_move = (rng()%2 == 0) ? black : white;
+  a_color[game] = spec.swap_colors ? white : black;
+
+  game_seeds seeds(rng());
+  policy_a.start(game, a_color[game], seeds);
+  policy_b.start(game, spec.swap_colors ? black : white, seeds);
+
+  // The same opening as tournament::play_opening().
+  games.reset(game, current_move);
+  for(unsigned ply=0; ply<opening_plies; ply++) {
+    games.update_moves(game);
+    if(games.result(game) != playing)
+      break;
+    games.move(game, games.random_move(game, games.to_move(game), rng));
+  }
+}
+
+template <typename TBlackPolicy, typename TWhitePolicy>
+void batch_tournament<TBlackPolicy, TWhitePolicy>::play(const batch_game* specs, unsigned count, round_winner* results) {
+  game_batch games(board_size, count);
+  TBlackPolicy policy_a(count);
+  TWhitePolicy policy_b(count);
+  std::vector<player> a_color(count);
+
+  for(unsigned g=0; g<count; g++)
+    set_up(games, g, specs[g], policy_a, policy_b, a_color);
+
+  // Games still playing, and those in which each policy is to move.
+  std::vector<unsigned> active(count), a_moving, b_moving;
+  std::vector<batch_move> a_moves(count), b_moves(count);
+  for(unsigned g=0; g<count; g++)
+    active[g] = g;
+
+  unsigned long long plies = 0, illegal = 0;
+
+  while(!active.empty()) {
+    games.update_moves(active.data(), active.size());
+
+    a_moving.clear();
+    b_moving.clear();
+    unsigned still_active = 0;
+    for(unsigned i=0; i<active.size(); i++) {
+      unsigned g = active[i];
+      game_outcome result = games.result(g);
+
+      if(result != playing) {
+	results[g].black = result != white_won;
+	results[g].white = result != black_won;
+	continue;
+      }
+
+      active[still_active++] = g;
+      if(games.to_move(g) == a_color[g])
+	a_moving.push_back(g);
+      else
+	b_moving.push_back(g);
+    }
+    active.resize(still_active);
+
+    policy_a.choose(games, a_moving.data(), a_moving.size(), a_moves.data());
+    policy_b.choose(games, b_moving.data(), b_moving.size(), b_moves.data());
+
+    for(unsigned i=0; i<a_moving.size(); i++)
+      illegal += !games.move(a_moving[i], a_moves[i]);
+    for(unsigned i=0; i<b_moving.size(); i++)
+      illegal += !games.move(b_moving[i], b_moves[i]);
+    plies += still_active;
+  }
+
+  // Totals shared by concurrent play() calls.
+  static std::mutex totals_lock;
+  std::lock_guard<std::mutex> guard(totals_lock);
+  total_plies += plies;
+  illegal_moves += illegal;
+}
+
+#endif
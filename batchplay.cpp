@@ -0,0 +1,332 @@
+/*
+ * File: batchplay.cpp
+ * Author: Joshua T. Guerin
+ * Purpose: Driver for batched simulation.
+ *          Plays many games between simple policies in lockstep batches
+ *          (see batch.h) on every core and reports the results and
+ *          throughput.  Optionally replays every game with the
+ *          tournament to check that the outcomes are the same.
+ *
+ */
+
+
+#include <iostream>  // console io
+#include <chrono>    // Throughput
+#include <ctime>     // time() for the default seed
+#include <getopt.h>  // getopt()
+#include <cstdlib>   // atoi()
+#include <algorithm> // remove(), min()
+#include <vector>    // Games and results
+
+#include "batch.h"       // Templated classes that play batches of games.
+#include "tournament.h"  // Reference games (--check)
+#include "thread_pool.h" // Batch workers
+#include "types.h"       // Types associated with game/tournament.
+
+using namespace std;
+
+// Simulation Flags
+unsigned num_games=100000;
+unsigned grid_size=7;
+unsigned num_threads=0; // 0: one per hardware thread
+unsigned batch_size=1024;
+unsigned opening_plies=0;
+unsigned seed=time(NULL);
+bool paired_games=false;
+bool check_games=false;
+string black_policy="random", white_policy="ordered";
+
+
+void parse_args(int argc, char *argv[]);
+/*
+ * Description: Parses command line arguments, sets associated flags.
+ * Parameters:
+ *    int argc - argc that is passed into main()
+ *    int argv - argv that is passed into main()
+ */
+
+
+template <typename TBlackPolicy, typename TWhitePolicy>
+bool run();
+/*
+ * Description: Plays and reports the games between the selected
+ *              policies.  Returns false if --check found games that
+ *              differ from the tournament's.
+ */
+
+
+template <typename TBlackPolicy>
+bool run_white(const string& white_name, bool& agreed);
+/*
+ * Description: Runs with TBlackPolicy and the policy named white_name,
+ *              setting agreed to run()'s result.  Returns false if there
+ *              is no such policy.
+ */
+
+
+void help(string binary_name, string options);
+/*
+ * Description: Prints usage message if -h or --help flags arguments
+ *              are passed on the command line.
+ */
+
+
+int main(int argc, char *argv[]) {
+  parse_args(argc, argv);
+
+  if(grid_size < 2 || grid_size > game_batch::max_size) {
+    cerr << "Error: Batched games are played on 2x2 to "
+	 << game_batch::max_size << 'x' << game_batch::max_size
+	 << " boards." << endl;
+    return 1;
+  }
+
+  bool known, agreed = true;
+  if(black_policy == "random")
+    known = run_white<random_policy>(white_policy, agreed);
+  else if(black_policy == "ordered")
+    known = run_white<ordered_policy>(white_policy, agreed);
+  else {
+    white_policy = black_policy;
+    known = false;
+  }
+
+  if(!known) {
+    cerr << "Error: Unknown policy '" << white_policy << "'." << endl
+	 << "Policies are random and ordered." << endl;
+    return 1;
+  }
+
+  return agreed ? 0 : 1;
+}
+
+
+template <typename TBlackPolicy>
+bool run_white(const string& white_name, bool& agreed) {
+  if(white_name == "random")
+    agreed = run<TBlackPolicy, random_policy>();
+  else if(white_name == "ordered")
+    agreed = run<TBlackPolicy, ordered_policy>();
+  else
+    return false;
+  return true;
+}
+
+
+template <typename TBlackPolicy, typename TWhitePolicy>
+bool run() {
+  // With --paired each seed is played twice, colors swapped.
+  vector<batch_game> games(num_games);
+  for(unsigned i=0; i<num_games; i++) {
+    games[i].seed = paired_games ? seed + i/2 : seed + i;
+    games[i].swap_colors = paired_games && i % 2 == 1;
+  }
+
+  vector<round_winner> results(num_games);
+  batch_tournament<TBlackPolicy, TWhitePolicy> batches(grid_size,
+						       opening_plies);
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  {
+    thread_pool pool(num_threads ? num_threads :
+		     thread_pool::default_threads());
+    for(unsigned first=0; first<num_games; first+=batch_size) {
+      unsigned count = min(batch_size, num_games - first);
+      pool.submit([&batches, &games, &results, first, count]() {
+	  batches.play(&games[first], count, &results[first]);
+	});
+    }
+    pool.wait();
+  }
+  double seconds = chrono::duration<double>(chrono::steady_clock::now() -
+					    start).count();
+
+  // Agent a (the black policy) plays white in swapped games.
+  unsigned a_wins = 0, b_wins = 0, black_wins = 0, white_wins = 0;
+  for(unsigned i=0; i<num_games; i++) {
+    if(results[i].black && results[i].white)
+      continue;
+    bool a_won = results[i].black != games[i].swap_colors;
+    a_wins += a_won;
+    b_wins += !a_won;
+    black_wins += results[i].black;
+    white_wins += results[i].white;
+  }
+  unsigned ties = num_games - a_wins - b_wins;
+
+  cout << bold << "Total games: " << regular << num_games << " ("
+       << grid_size << 'x' << grid_size;
+  if(opening_plies > 0)
+    cout << ", " << opening_plies << "-ply random openings";
+  if(paired_games)
+    cout << ", colors swapped within each pair";
+  cout << ")" << endl
+       << bold << black_policy << " (a): " << regular << a_wins << " wins ("
+       << float(a_wins)/num_games * 100 << "%)" << endl
+       << bold << white_policy << " (b): " << regular << b_wins << " wins ("
+       << float(b_wins)/num_games * 100 << "%)" << endl
+       << bold << "Ties: " << regular << ties << " ("
+       << float(ties)/num_games * 100 << "%)" << endl
+       << bold << "By color: " << regular << black_wins << " black wins, "
+       << white_wins << " white wins" << endl
+       << bold << "Throughput: " << regular << num_games / seconds
+       << " games/s, " << batches.plies() / seconds << " plies/s ("
+       << seconds << " s)" << endl;
+  if(batches.illegal() > 0)
+    cout << bold << "Illegal moves skipped: " << regular
+	 << batches.illegal() << endl;
+
+  if(!check_games)
+    return true;
+
+  // The same games, one at a time, through the tournament and agents.
+  tournament<typename TBlackPolicy::reference_agent,
+	     typename TWhitePolicy::reference_agent>
+    reference(1, false, false, false, grid_size);
+  reference.set_opening_plies(opening_plies);
+
+  unsigned mismatches = 0;
+  start = chrono::steady_clock::now();
+  for(unsigned i=0; i<num_games; i++) {
+    round_winner expected = reference.run_simulation(games[i].seed,
+						     games[i].swap_colors);
+    if(!(expected == results[i])) {
+      if(mismatches == 0)
+	cerr << "Error: Game " << i << " (seed " << games[i].seed
+	     << ") differs from the tournament." << endl;
+      mismatches++;
+    }
+  }
+  double reference_seconds =
+    chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+  cout << bold << "Check: " << regular << num_games - mismatches << " of "
+       << num_games << " outcomes match tournament::run_simulation ("
+       << num_games / reference_seconds << " games/s on one thread)" << endl;
+  return mismatches == 0;
+}
+
+
+void parse_args(int argc, char *argv[]) {
+  int option;
+  opterr = 0;
+
+  // getopt_long arguments
+  string options = "b:cg:hj:n:";
+  const struct option long_options[] =
+    {
+      {"batch",       required_argument,  0, 'b'},
+      {"check",       no_argument,        0, 'c'},
+      {"grid",        required_argument,  0, 'g'},
+      {"help",        no_argument,        0, 'h'},
+      {"threads",     required_argument,  0, 'j'},
+      {"games",       required_argument,  0, 'n'},
+      {"black",       required_argument,  0, 'B'},
+      {"white",       required_argument,  0, 'W'},
+      {"openings",    required_argument,  0, 'O'},
+      {"paired",      no_argument,        0, 'R'},
+      {"seed",        required_argument,  0, 'D'},
+      {0,0,0,0},
+    };
+  int option_index;
+
+  option = getopt_long(argc, argv, options.c_str(),
+		       long_options, &option_index);
+
+  while(option != -1) {
+    switch(option) {
+    case 'b':
+      // Games per lockstep batch
+      batch_size = atoi(optarg);
+      if(batch_size == 0)
+	batch_size = 1;
+      break;
+    case 'c':
+      // Replay every game with the tournament
+      check_games = true;
+      break;
+    case 'g':
+      // Grid size flag
+      grid_size = atoi(optarg);
+      break;
+    case 'h':
+      // Help flag
+      help(argv[0], options);
+      exit(0);
+      break;
+    case 'j':
+      // Number of worker threads
+      num_threads = atoi(optarg);
+      break;
+    case 'n':
+      // Number of games to play
+      num_games = atoi(optarg);
+      break;
+    case 'B':
+      // Policy of agent a, black unless colors are swapped (long option only)
+      black_policy = optarg;
+      break;
+    case 'W':
+      // Policy of agent b (long option only)
+      white_policy = optarg;
+      break;
+    case 'O':
+      // Random opening length (long option only)
+      opening_plies = atoi(optarg);
+      break;
+    case 'R':
+      // Paired scheduling (long option only)
+      paired_games = true;
+      break;
+    case 'D':
+      // Seed (long option only)
+      seed = strtoul(optarg, NULL, 10);
+      break;
+    case '?':
+      cerr << "Error: Unrecognized argument or missing value." << endl
+	   << "See the -h option for usage." << endl;
+      exit(0);
+      break;
+    default:
+      cerr << "Error: Unknown argument: " << char(option) << endl;
+      exit(0);
+      break;
+    }
+
+    option = getopt_long(argc, argv, options.c_str(),
+			 long_options, &option_index);
+  }
+}
+
+
+void help(string binary_name, string options) {
+  options.erase(remove(options.begin(), options.end(), ':'), options.end());
+
+  cout << bold << "NAME\n\t" << binary_name << regular << " -- plays batches of isola games between simple policies" << endl
+       << bold << "SYNOPSIS: \n\t" << binary_name
+       << " [-" << options << "]" << regular << endl
+       << bold << "OPTIONS:" << regular << endl
+       << bold << "-b | --batch n" << regular
+       << "        Plays " << bold << 'n' << regular << " games in lockstep per batch (default: 1024)." << endl
+       << bold << "-c | --check" << regular
+       << "          Replays every game with the tournament and agents and" << endl
+       << "                      checks that the outcomes match (exits with 1 if" << endl
+       << "                      any differs)." << endl
+       << bold << "-g | --grid n" << regular
+       << "         Sets gameboard size to " << bold << 'n' << regular << 'x' << bold << 'n' << regular << " (at most 8x8)." << endl
+       << bold << "-h | --help" << regular
+       << "           Print this help." << endl
+       << bold << "-j | --threads n" << regular
+       << "      Uses " << bold << 'n' << regular << " worker threads (default: all hardware threads)." << endl
+       << bold << "-n | --games n" << regular
+       << "        Plays " << bold << 'n' << regular << " games (default: 100000)." << endl
+       << bold << "--black name, --white name" << endl << regular
+       << "                      Policies of the two sides: random (default black) or" << endl
+       << "                      ordered (default white)." << endl
+       << bold << "--openings n" << regular
+       << "          Starts each game from " << bold << 'n' << regular << " random legal moves." << endl
+       << bold << "--paired" << regular
+       << "              Plays every seed twice, with the colors swapped." << endl
+       << bold << "--seed n" << regular
+       << "              Seeds game i with n+i (default: time), as" << endl
+       << "                      tournament::run_simulation() would." << endl;
+}
@@ -0,0 +1,78 @@
+/*
+ * File: bitboard.h
+ * Author: Joshua T. Guerin
+ * Purpose: A set of squares stored one bit per square in 64-bit words, so
+ *          boards of any size (e.g., 64x64 = 64 words) can be counted and
+ *          iterated without visiting every square.
+ *
+ * Note: Squares are numbered row*n + col.  Iteration (first()/next()) is
+ *       in increasing square order, i.e., row by row.
+ */
+
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <stdint.h> // uint64_t
+#include <vector>   // Words
+
+
+class bitboard {
+ private:
+  std::vector<uint64_t> words;
+  unsigned bits;
+
+ public:
+  bitboard() : bits(0) {}
+
+  explicit bitboard(unsigned size) : words((size + 63) / 64, 0), bits(size) {}
+  /*
+   * Description: An empty set of squares 0 ... size-1.
+   */
+
+  unsigned size() const { return bits; }
+
+  bool test(unsigned square) const {
+    return (words[square / 64] >> (square % 64)) & 1;
+  }
+
+  void set(unsigned square) {
+    words[square / 64] |= uint64_t(1) << (square % 64);
+  }
+
+  void reset(unsigned square) {
+    words[square / 64] &= ~(uint64_t(1) << (square % 64));
+  }
+
+  unsigned count() const {
+    /*
+     * Description: Number of squares in the set.  O(words).
+     */
+    unsigned total = 0;
+    for(unsigned i=0; i<words.size(); i++)
+      total += __builtin_popcountll(words[i]);
+    return total;
+  }
+
+  unsigned next(unsigned square) const {
+    /*
+     * Description: The first square >= square in the set, or size() if
+     *              there is none.  Skips empty words whole.
+     */
+    if(square >= bits)
+      return bits;
+
+    unsigned w = square / 64;
+    uint64_t word = words[w] & (~uint64_t(0) << (square % 64));
+
+    while(word == 0) {
+      if(++w == words.size())
+	return bits;
+      word = words[w];
+    }
+    return w * 64 + __builtin_ctzll(word);
+  }
+
+  unsigned first() const { return next(0); }
+};
+
+#endif
@@ -0,0 +1,224 @@
+/*
+ * File: checkpoint.cpp
+ * Author: Joshua T. Guerin
+ * Description: Reading and writing tournament checkpoints.  See
+ *              checkpoint.h for the format.
+ */
+
+#include <cstdio>    // fopen(), fprintf(), rename()
+#include <fstream>   // Checkpoint files
+#include <iostream>  // Errors
+#include <sstream>   // Values
+#include <unistd.h>  // fsync()
+
+#include "checkpoint.h"
+
+using namespace std;
+
+
+static bool read_field(istream& file, const string& filename,
+		       const char* key, string& rest);
+/*
+ * Description: Reads the next line of file, which must be key followed by
+ *              a value (rest).  Writes an error to cerr otherwise.
+ */
+
+template <typename... TValues>
+static bool parse_values(const string& rest, const string& filename,
+			 const char* key, TValues&... values);
+/*
+ * Description: Reads exactly the values from rest, the value of key's
+ *              line.  Writes an error to cerr otherwise.
+ */
+
+template <typename... TValues>
+static bool read_values(istream& file, const string& filename,
+			const char* key, TValues&... values);
+/*
+ * Description: read_field(), then parse_values().
+ */
+
+static bool read_end(istream& file, const string& filename);
+/*
+ * Description: Reads the end marker.  Writes an error to cerr if it is
+ *              missing.
+ */
+
+
+tournament_checkpoint::tournament_checkpoint()
+  : paired(false), grid_size(0), opening_plies(0), sequential_test(false),
+    elo0(0), elo1(0), lower_bound(0), upper_bound(0), base_seed(0),
+    games(0) {
+  for(unsigned k=0; k<5; k++)
+    pair_scores[k] = 0;
+}
+
+
+bool tournament_checkpoint::save(const string& filename) const {
+  string temporary = filename + ".tmp";
+  FILE* file = fopen(temporary.c_str(), "w");
+  if(!file)
+    return false;
+
+  fprintf(file, "isola-checkpoint %d\n", CHECKPOINT_VERSION);
+  fprintf(file, "black %s\nwhite %s\n", black_name.c_str(),
+	  white_name.c_str());
+  fprintf(file, "paired %d\ngrid %u\nopenings %u\n", paired ? 1 : 0,
+	  grid_size, opening_plies);
+  // %.17g reads back as exactly the same double.
+  if(sequential_test)
+    fprintf(file, "test %.17g %.17g %.17g %.17g\n", elo0, elo1, lower_bound,
+	    upper_bound);
+  else
+    fprintf(file, "test none\n");
+  fprintf(file, "seed %u\ngames %u\n", base_seed, games);
+  fprintf(file, "results %u %u %u\n", results.wins, results.ties,
+	  results.losses);
+  fprintf(file, "pairs %u %u %u %u %u\n", pair_scores[0], pair_scores[1],
+	  pair_scores[2], pair_scores[3], pair_scores[4]);
+  fprintf(file, "sprt %u %u %u\n", sprt_games.wins, sprt_games.ties,
+	  sprt_games.losses);
+  fprintf(file, "end\n");
+
+  // On disk before it replaces the last good checkpoint.
+  bool written = fflush(file) == 0 && !ferror(file) &&
+    fsync(fileno(file)) == 0;
+  written = fclose(file) == 0 && written;
+  if(!written) {
+    remove(temporary.c_str());
+    return false;
+  }
+
+  return rename(temporary.c_str(), filename.c_str()) == 0;
+}
+
+
+bool tournament_checkpoint::load(const string& filename) {
+  ifstream file(filename.c_str());
+  string rest;
+
+  if(!file) {
+    cerr << "Error: Could not open checkpoint " << filename << "." << endl;
+    return false;
+  }
+
+  if(!read_field(file, filename, "isola-checkpoint", rest))
+    return false;
+  if(rest != to_string(CHECKPOINT_VERSION)) {
+    cerr << "Error: " << filename << " is a version " << rest
+	 << " checkpoint (expected version " << CHECKPOINT_VERSION << ")."
+	 << endl;
+    return false;
+  }
+
+  // Names are the rest of the line; everything else is numbers.
+  if(!read_field(file, filename, "black", black_name) ||
+     !read_field(file, filename, "white", white_name))
+    return false;
+
+  unsigned flag;
+  if(!read_values(file, filename, "paired", flag))
+    return false;
+  if(flag > 1) {
+    cerr << "Error: Checkpoint " << filename << " has a malformed 'paired' "
+	 << "line." << endl;
+    return false;
+  }
+  paired = flag == 1;
+
+  if(!read_values(file, filename, "grid", grid_size) ||
+     !read_values(file, filename, "openings", opening_plies))
+    return false;
+
+  // "test none", or the SPRT's hypotheses and bounds.
+  if(!read_field(file, filename, "test", rest))
+    return false;
+  sequential_test = rest != "none";
+  if(sequential_test &&
+     !parse_values(rest, filename, "test", elo0, elo1, lower_bound,
+		   upper_bound))
+    return false;
+
+  return read_values(file, filename, "seed", base_seed) &&
+    read_values(file, filename, "games", games) &&
+    read_values(file, filename, "results", results.wins, results.ties,
+		results.losses) &&
+    read_values(file, filename, "pairs", pair_scores[0], pair_scores[1],
+		pair_scores[2], pair_scores[3], pair_scores[4]) &&
+    read_values(file, filename, "sprt", sprt_games.wins, sprt_games.ties,
+		sprt_games.losses) &&
+    read_end(file, filename);
+}
+
+
+bool tournament_checkpoint::same_tournament(
+  const tournament_checkpoint& other) const {
+  if(sequential_test != other.sequential_test)
+    return false;
+  if(sequential_test &&
+     (elo0 != other.elo0 || elo1 != other.elo1 ||
+      lower_bound != other.lower_bound || upper_bound != other.upper_bound))
+    return false;
+
+  return black_name == other.black_name && white_name == other.white_name &&
+    paired == other.paired && grid_size == other.grid_size &&
+    opening_plies == other.opening_plies;
+}
+
+
+static bool read_field(istream& file, const string& filename,
+		       const char* key, string& rest) {
+  string line;
+  if(!getline(file, line)) {
+    cerr << "Error: Checkpoint " << filename << " ends before its '" << key
+	 << "' line." << endl;
+    return false;
+  }
+
+  size_t space = line.find(' ');
+  if(line.substr(0, space) != key || space == string::npos ||
+     space + 1 == line.size()) {
+    cerr << "Error: Checkpoint " << filename << " has \"" << line
+	 << "\" where its '" << key << "' line should be." << endl;
+    return false;
+  }
+
+  rest = line.substr(space + 1);
+  return true;
+}
+
+
+template <typename... TValues>
+static bool read_values(istream& file, const string& filename,
+			const char* key, TValues&... values) {
+  string rest;
+  return read_field(file, filename, key, rest) &&
+    parse_values(rest, filename, key, values...);
+}
+
+
+template <typename... TValues>
+static bool parse_values(const string& rest, const string& filename,
+			 const char* key, TValues&... values) {
+  istringstream value(rest);
+  int reads[] = { ((value >> values), 0)... };
+  (void)reads;
+  if(value.fail() || !(value >> ws).eof()) {
+    cerr << "Error: Checkpoint " << filename << " has a malformed '" << key
+	 << "' line." << endl;
+    return false;
+  }
+  return true;
+}
+
+
+static bool read_end(istream& file, const string& filename) {
+  // A file cut short after its last complete line has no end marker.
+  string line;
+  if(!getline(file, line) || line != "end") {
+    cerr << "Error: Checkpoint " << filename << " has no end line "
+	 << "(incomplete file)." << endl;
+    return false;
+  }
+  return true;
+}
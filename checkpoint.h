@@ -0,0 +1,87 @@
+/*
+ * File: checkpoint.h
+ * Author: Joshua T. Guerin
+ * Purpose: The state of a tournament in progress, saved to a small file
+ *          so that a long run (e.g., -s 1000000) that is interrupted can
+ *          be resumed exactly where it left off (see tournament::resume()).
+ *
+ * Method: A tournament seeds game i with base_seed + i (paired: pair i),
+ *         so a game's opening, first mover and its agents' seeds
+ *         (seeds.h) depend only on the base seed and i.  The tallies, the
+ *         base seed and the number of games played are then all the state
+ *         there is: a resumed run plays exactly the games the
+ *         uninterrupted run would have.
+ *
+ * File format: text, one "key value" pair per line, in this order:
+ *     isola-checkpoint 2
+ *     black Alpha-Beta Agent       black (paired: first) agent's name
+ *     white MCTS Agent             white (paired: second) agent's name
+ *     paired 0                     1 for paired scheduling
+ *     grid 7                       board size
+ *     openings 0                   random opening plies
+ *     test 0 5 -2.94 2.94          SPRT elo0, elo1 and LLR bounds, or
+ *                                  "test none"
+ *     seed 1804289383              base seed
+ *     games 1200                   games played (paired: pairs)
+ *     results 610 12 578           wins ties losses of black (paired:
+ *                                  of the first agent)
+ *     pairs 0 0 0 0 0              paired: pairs scoring 0 ... 2 points
+ *     sprt 610 12 578              games added to the SPRT
+ *     end
+ *     Every line is required; a file that is cut short or has a
+ *     malformed line is rejected.
+ */
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <string> // Agent names, file names
+
+#include "elo.h"  // match_score
+
+#define CHECKPOINT_VERSION 2
+
+
+struct tournament_checkpoint {
+  /*
+   * See the file format above.
+   */
+  std::string black_name, white_name;
+  bool paired;
+  unsigned grid_size;
+  unsigned opening_plies;
+  bool sequential_test;
+  double elo0, elo1, lower_bound, upper_bound;
+  unsigned base_seed;
+  unsigned games;
+  match_score results;
+  unsigned pair_scores[5];
+  match_score sprt_games;
+
+  tournament_checkpoint();
+
+  bool save(const std::string& filename) const;
+  /*
+   * Description: Writes the checkpoint to filename, through a temporary
+   *              file that is synced to disk and then renamed over it, so
+   *              an interruption (or crash) never leaves a partly written
+   *              checkpoint.
+   */
+
+  bool load(const std::string& filename);
+  /*
+   * Returns:
+   *     false - filename could not be read, or is not a complete
+   *             checkpoint of this version (the reason is written to
+   *             cerr).
+   */
+
+  bool same_tournament(const tournament_checkpoint& other) const;
+  /*
+   * Description: Whether other was saved by a tournament with the same
+   *              agents and settings (names, paired, grid, openings, SPRT
+   *              hypotheses and bounds).
+   */
+};
+
+#endif
@@ -0,0 +1,103 @@
+/*
+ * File: elo.h
+ * Author: Joshua T. Guerin
+ * Purpose: Elo rating helpers for reporting match results.
+ *
+ * Notes: Scores are expected scores in [0, 1] (win = 1, tie = 0.5,
+ *        loss = 0).  Elo differences use the usual logistic model:
+ *            score = 1 / (1 + 10^(-elo/400))
+ */
+
+#ifndef ELO_H
+#define ELO_H
+
+#include <cmath>  // log10(), pow(), sqrt()
+#include <limits> // infinity()
+
+
+struct match_score {
+  /*
+   * Wins, ties, and losses from one agent's point of view.
+   */
+  unsigned wins, ties, losses;
+
+  match_score() : wins(0), ties(0), losses(0) {}
+
+  inline unsigned games() const { return wins + ties + losses; }
+
+  inline double score() const {
+    // Mean score per game (0.5 when no games have been played).
+    if(games() == 0)
+      return 0.5;
+    return (wins + 0.5*ties) / games();
+  }
+
+  inline double points() const { return wins + 0.5*ties; }
+
+  inline match_score& operator+=(const match_score& rhs) {
+    wins += rhs.wins; ties += rhs.ties; losses += rhs.losses;
+    return *this;
+  }
+};
+
+
+inline double elo_from_score(double score) {
+  /*
+   * Description: Converts an expected score into an Elo difference.
+   *              Returns +/-infinity for perfect scores.
+   */
+  if(score <= 0)
+    return -std::numeric_limits<double>::infinity();
+  if(score >= 1)
+    return std::numeric_limits<double>::infinity();
+  return -400.0 * std::log10(1.0/score - 1.0);
+}
+
+
+inline double score_from_elo(double elo) {
+  /*
+   * Description: Converts an Elo difference into an expected score.
+   */
+  return 1.0 / (1.0 + std::pow(10.0, -elo/400.0));
+}
+
+
+inline double score_std_error(const match_score& m) {
+  /*
+   * Description: Standard error of the mean score of m, computed from the
+   *              observed win/tie/loss frequencies.
+   */
+  unsigned n = m.games();
+  if(n == 0)
+    return 0;
+
+  double s = m.score();
+  double variance = (m.wins * (1 - s)*(1 - s) +
+		     m.ties * (0.5 - s)*(0.5 - s) +
+		     m.losses * s*s) / n;
+  return std::sqrt(variance / n);
+}
+
+
+inline void elo_interval(double score, double std_error,
+			 double& low, double& high) {
+  /*
+   * Description: Computes a 95% confidence interval [low, high] of the
+   *              Elo difference implied by a mean score and its standard
+   *              error.
+   */
+  double margin = 1.96 * std_error;
+  low = elo_from_score(score - margin);
+  high = elo_from_score(score + margin);
+}
+
+
+inline void elo_interval(const match_score& m, double& low, double& high) {
+  /*
+   * Description: Computes a 95% confidence interval [low, high] of the
+   *              Elo difference implied by m.
+   */
+  elo_interval(m.score(), score_std_error(m), low, high);
+}
+
+#endif
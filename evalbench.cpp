@@ -0,0 +1,308 @@
+/*
+ * File: evalbench.cpp
+ * Author: Joshua T. Guerin
+ * Purpose: Benchmarks evaluation functions: the handcrafted mobility
+ *          evaluation against the quantized network (nnue.h), both
+ *          rebuilt from scratch and updated incrementally as in search.
+ *          Also checks that incremental updates match a full refresh.
+ *
+ */
+
+
+#include <iostream>  // console io
+#include <chrono>    // Timing
+#include <getopt.h>  // getopt()
+#include <cstdlib>   // atoi()
+#include <algorithm> // remove()
+#include <random>    // Random positions
+#include <vector>    // Positions
+
+#include "isola.h" // Game logic
+#include "nnue.h"  // Network evaluation
+#include "types.h" // Types associated with game/tournament.
+
+using namespace std;
+
+// Benchmark Flags
+unsigned grid_size=7;
+unsigned num_positions=10000;
+unsigned hidden_size=128;
+unsigned seed=1;
+string network_file, save_file;
+
+
+struct sample {
+  // A position, its side to move, and one legal action from it.
+  isola board;
+  player to_move;
+  action next;
+  sample(const isola& b, player p, const action& a)
+    : board(b), to_move(p), next(a) {}
+};
+
+
+void parse_args(int argc, char *argv[]);
+/*
+ * Description: Parses command line arguments, sets associated flags.
+ */
+
+
+void help(string binary_name, string options);
+/*
+ * Description: Prints usage message if -h or --help flags arguments
+ *              are passed on the command line.
+ */
+
+
+vector<sample> random_positions(unsigned count);
+/*
+ * Description: Collects count positions from random games.
+ */
+
+
+template <typename TFunction>
+double evals_per_second(unsigned count, TFunction evaluate_all);
+/*
+ * Description: Repeats evaluate_all() (which performs count evaluations)
+ *              for about half a second and returns evaluations/second.
+ */
+
+
+int main(int argc, char *argv[]) {
+  parse_args(argc, argv);
+
+  nnue_network network;
+  if(network_file.empty())
+    network.randomize(grid_size, hidden_size, seed);
+  else if(!network.load(network_file)) {
+    cerr << "Error: Could not load network " << network_file << "." << endl;
+    return 1;
+  }
+  grid_size = network.board_size;
+
+  if(!save_file.empty() && !network.save(save_file)) {
+    cerr << "Error: Could not save network " << save_file << "." << endl;
+    return 1;
+  }
+
+  vector<sample> positions = random_positions(num_positions);
+  vector<nnue_accumulator> accumulators(positions.size());
+  for(unsigned i=0; i<positions.size(); i++)
+    accumulators[i].refresh(network, positions[i].board);
+
+  // Incremental updates must agree with rebuilding the child position.
+  unsigned mismatches = 0;
+  for(unsigned i=0; i<positions.size(); i++) {
+    sample& s = positions[i];
+    nnue_accumulator incremental = accumulators[i], full;
+    isola child = s.board;
+
+    incremental.move(s.board, s.to_move, s.next);
+    child.move(s.to_move, s.next.move_to, s.next.remove);
+    full.refresh(network, child);
+    if(incremental.evaluate(s.to_move) != full.evaluate(s.to_move))
+      mismatches++;
+  }
+
+  volatile long sink = 0;
+
+  double mobility = evals_per_second(positions.size(), [&]() {
+      long total = 0;
+      for(unsigned i=0; i<positions.size(); i++) {
+	player p = positions[i].to_move;
+	player q = (p == black) ? white : black;
+	total += int(positions[i].board.mobility(p)) -
+	  int(positions[i].board.mobility(q));
+      }
+      sink = total;
+    });
+
+  double refreshed = evals_per_second(positions.size(), [&]() {
+      long total = 0;
+      nnue_accumulator scratch;
+      for(unsigned i=0; i<positions.size(); i++) {
+	scratch.refresh(network, positions[i].board);
+	total += scratch.evaluate(positions[i].to_move);
+      }
+      sink = total;
+    });
+
+  double incremental = evals_per_second(positions.size(), [&]() {
+      long total = 0;
+      for(unsigned i=0; i<positions.size(); i++) {
+	sample& s = positions[i];
+	accumulators[i].move(s.board, s.to_move, s.next);
+	total += accumulators[i].evaluate(s.to_move);
+	accumulators[i].undo(s.board, s.to_move, s.next);
+      }
+      sink = total;
+    });
+
+  double evaluate_only = evals_per_second(positions.size(), [&]() {
+      long total = 0;
+      for(unsigned i=0; i<positions.size(); i++)
+	total += accumulators[i].evaluate(positions[i].to_move);
+      sink = total;
+    });
+
+  cout << bold << "Evaluation benchmark" << regular << " ("
+       << positions.size() << " positions, " << grid_size << 'x'
+       << grid_size << ", hidden " << network.hidden_size << ", "
+#ifdef __AVX2__
+       << "AVX2"
+#else
+       << "scalar"
+#endif
+       << ")" << endl
+       << bold << "Mobility:               " << regular
+       << long(mobility) << " evals/s" << endl
+       << bold << "Network, full refresh:  " << regular
+       << long(refreshed) << " evals/s" << endl
+       << bold << "Network, incremental:   " << regular
+       << long(incremental) << " evals/s (update + evaluate + undo)" << endl
+       << bold << "Network, layers 2-3:    " << regular
+       << long(evaluate_only) << " evals/s" << endl
+       << bold << "Incremental mismatches: " << regular
+       << mismatches << endl;
+
+  return mismatches == 0 ? 0 : 1;
+}
+
+
+vector<sample> random_positions(unsigned count) {
+  mt19937 rng(seed);
+  vector<sample> positions;
+
+  while(positions.size() < count) {
+    isola game(grid_size);
+    player current_move = (rng()%2 == 0) ? black : white;
+
+    while(game.game_result() == playing && positions.size() < count) {
+      vector<action> moves = game.legal_actions(current_move);
+      action next = moves[rng() % moves.size()];
+
+      positions.push_back(sample(game, current_move, next));
+      game.move(current_move, next.move_to, next.remove);
+      current_move = (current_move == white) ? black : white;
+    }
+  }
+
+  return positions;
+}
+
+
+template <typename TFunction>
+double evals_per_second(unsigned count, TFunction evaluate_all) {
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  double seconds = 0;
+  unsigned long long evaluations = 0;
+
+  while(seconds < 0.5) {
+    evaluate_all();
+    evaluations += count;
+    seconds = chrono::duration<double>(chrono::steady_clock::now() - start)
+      .count();
+  }
+
+  return evaluations / seconds;
+}
+
+
+void parse_args(int argc, char *argv[]) {
+  int option;
+  opterr = 0;
+
+  // getopt_long arguments
+  string options = "f:g:hn:";
+  const struct option long_options[] =
+    {
+      {"network",     required_argument,  0, 'f'},
+      {"grid",        required_argument,  0, 'g'},
+      {"help",        no_argument,        0, 'h'},
+      {"positions",   required_argument,  0, 'n'},
+      {"hidden",      required_argument,  0, 'H'},
+      {"save",        required_argument,  0, 'S'},
+      {"seed",        required_argument,  0, 'D'},
+      {0,0,0,0},
+    };
+  int option_index;
+
+  option = getopt_long(argc, argv, options.c_str(),
+		       long_options, &option_index);
+
+  while(option != -1) {
+    switch(option) {
+    case 'f':
+      // Network file
+      network_file = optarg;
+      break;
+    case 'g':
+      // Grid size flag
+      grid_size = atoi(optarg);
+      break;
+    case 'h':
+      // Help flag
+      help(argv[0], options);
+      exit(0);
+      break;
+    case 'n':
+      // Number of positions
+      num_positions = atoi(optarg);
+      break;
+    case 'H':
+      // Hidden layer size of a random network (long option only)
+      hidden_size = atoi(optarg);
+      if(hidden_size == 0 || hidden_size % 32 != 0 ||
+	 hidden_size > nnue_network::max_hidden) {
+	cerr << "Error: --hidden must be a multiple of 32 up to "
+	     << nnue_network::max_hidden << "." << endl;
+	exit(0);
+      }
+      break;
+    case 'S':
+      // Save the network (long option only)
+      save_file = optarg;
+      break;
+    case 'D':
+      // Seed (long option only)
+      seed = strtoul(optarg, NULL, 10);
+      break;
+    case '?':
+      cerr << "Error: Unrecognized argument or missing value." << endl
+	   << "See the -h option for usage." << endl;
+      exit(0);
+      break;
+    default:
+      cerr << "Error: Unknown argument: " << char(option) << endl;
+      exit(0);
+      break;
+    }
+
+    option = getopt_long(argc, argv, options.c_str(),
+			 long_options, &option_index);
+  }
+}
+
+
+void help(string binary_name, string options) {
+  options.erase(remove(options.begin(), options.end(), ':'), options.end());
+
+  cout << bold << "NAME\n\t" << binary_name << regular << " -- benchmarks isola evaluation functions" << endl
+       << bold << "SYNOPSIS: \n\t" << binary_name
+       << " [-" << options << "]" << regular << endl
+       << bold << "OPTIONS:" << regular << endl
+       << bold << "-f | --network file" << regular
+       << "   Loads a network (default: random weights)." << endl
+       << bold << "-g | --grid n" << regular
+       << "         Board size of a random network (default: 7)." << endl
+       << bold << "-h | --help" << regular
+       << "           Print this help." << endl
+       << bold << "-n | --positions n" << regular
+       << "    Number of positions (default: 10000)." << endl
+       << bold << "--hidden n" << regular
+       << "            Hidden size of a random network (default: 128)." << endl
+       << bold << "--save file" << regular
+       << "           Saves the network to " << bold << "file" << regular << '.' << endl
+       << bold << "--seed n" << regular
+       << "              Seeds the positions and random network." << endl;
+}
@@ -0,0 +1,65 @@
+/*
+ * File: evaluation.cpp
+ * Author: Joshua T. Guerin
+ * Description: Evaluation weights: defaults and the weights file.  See
+ *              evaluation.h for the features.
+ */
+
+#include <fstream> // Weights file
+
+#include "evaluation.h"
+
+using namespace std;
+
+static const char* feature_names[num_features] = {
+  "mobility", "centre", "reachable"
+};
+
+
+eval_weights::eval_weights() {
+  for(unsigned f=0; f<num_features; f++)
+    weight[f] = 0;
+  weight[mobility_feature] = 1;
+}
+
+
+const char* eval_weights::feature_name(unsigned f) {
+  return f < num_features ? feature_names[f] : "";
+}
+
+
+double eval_weights::evaluate(const double features[num_features]) const {
+  double value = 0;
+  for(unsigned f=0; f<num_features; f++)
+    value += weight[f] * features[f];
+  return value;
+}
+
+
+bool eval_weights::load(const string& filename) {
+  ifstream file(filename.c_str());
+  string name;
+  double value;
+
+  if(!file)
+    return false;
+
+  // Unknown names are skipped so that files from later versions load.
+  while(file >> name >> value)
+    for(unsigned f=0; f<num_features; f++)
+      if(name == feature_names[f])
+	weight[f] = value;
+
+  return file.eof();
+}
+
+
+bool eval_weights::save(const string& filename) const {
+  ofstream file(filename.c_str());
+
+  file.precision(17);
+  for(unsigned f=0; f<num_features; f++)
+    file << feature_names[f] << ' ' << weight[f] << endl;
+
+  return bool(file);
+}
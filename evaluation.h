@@ -0,0 +1,199 @@
+/*
+ * File: evaluation.h
+ * Author: Joshua T. Guerin
+ * Purpose: Handcrafted evaluation features and their weights, shared by
+ *          search agents (which evaluate isola boards) and the tuner
+ *          (which evaluates packed position records in bulk).
+ *
+ * Features: Each is a difference, side to move minus opponent:
+ *     mobility  - legal pawn moves
+ *     centre    - closeness to the centre (opponent's Chebyshev distance
+ *                 minus ours)
+ *     reachable - squares reachable by a sequence of pawn moves
+ *
+ * Notes: The evaluation is the weighted sum of the features.  Weights are
+ *        stored in a small text file, one "name value" pair per line.
+ */
+
+#ifndef EVALUATION_H
+#define EVALUATION_H
+
+#include <algorithm> // max()
+#include <string>    // File names
+#include <vector>    // Flood fill
+
+#include "isola.h"   // Game logic
+#include "records.h" // Packed positions
+#include "types.h"   // Isola/tournament types.
+
+enum eval_feature {
+  mobility_feature, centre_feature, reachable_feature, num_features
+};
+
+
+struct eval_weights {
+  /*
+   * Description: One weight per feature.  The defaults (mobility only)
+   *              match the untuned mobility heuristic.
+   */
+  double weight[num_features];
+
+  eval_weights();
+
+  bool load(const std::string& filename);
+  /*
+   * Returns:
+   *     false - the file could not be read.  Features missing from the
+   *             file keep their current weight.
+   */
+
+  bool save(const std::string& filename) const;
+
+  double evaluate(const double features[num_features]) const;
+
+  static const char* feature_name(unsigned f);
+};
+
+
+class isola_squares {
+  /*
+   * Description: Square access for feature computation on an isola board.
+   */
+ private:
+  isola& board;
+ public:
+  isola_squares(isola& b) : board(b) {}
+  unsigned size() { return board.max_rows(); }
+  bool open(unsigned row, unsigned col) { return board[row][col] == ' '; }
+};
+
+
+class packed_squares {
+  /*
+   * Description: Square access for feature computation directly on a
+   *              packed position record (no isola is built).
+   */
+ private:
+  const position_record& record;
+ public:
+  packed_squares(const position_record& r) : record(r) {}
+  unsigned size() { return record.board_size; }
+  bool open(unsigned row, unsigned col) {
+    unsigned square = row * record.board_size + col;
+    return !record.is_removed(square) && square != record.black_square &&
+      square != record.white_square;
+  }
+};
+
+
+template <typename TSquares>
+unsigned count_mobility(TSquares& squares, location pawn) {
+  /*
+   * Description: Number of open squares next to pawn.
+   */
+  unsigned n = squares.size(), count = 0;
+
+  for(int dr=-1; dr<=1; dr++) {
+    for(int dc=-1; dc<=1; dc++) {
+      unsigned r = pawn.row + dr, c = pawn.col + dc;
+      if((dr != 0 || dc != 0) && r < n && c < n && squares.open(r, c))
+	count++;
+    }
+  }
+  return count;
+}
+
+
+template <typename TSquares>
+unsigned count_reachable(TSquares& squares, location pawn) {
+  /*
+   * Description: Number of open squares pawn could reach by moving any
+   *              number of times (flood fill over the 8 directions).
+   */
+  static thread_local std::vector<unsigned char> seen;
+  static thread_local std::vector<location> frontier;
+  unsigned n = squares.size(), count = 0;
+
+  seen.assign(n * n, 0);
+  frontier.clear();
+  frontier.push_back(pawn);
+  seen[pawn.row * n + pawn.col] = 1;
+
+  while(!frontier.empty()) {
+    location current = frontier.back();
+    frontier.pop_back();
+
+    for(int dr=-1; dr<=1; dr++) {
+      for(int dc=-1; dc<=1; dc++) {
+	unsigned r = current.row + dr, c = current.col + dc;
+	if(r >= n || c >= n || seen[r * n + c] || !squares.open(r, c))
+	  continue;
+	seen[r * n + c] = 1;
+	frontier.push_back(location(r, c));
+	count++;
+      }
+    }
+  }
+  return count;
+}
+
+
+template <typename TSquares>
+void compute_features(TSquares& squares, location own, location opponent,
+		      double features[num_features],
+		      const eval_weights* only_weighted = 0) {
+  /*
+   * Description: Fills features for the side to move (pawn at own).  If
+   *              only_weighted is given, features whose weight is 0 are
+   *              skipped (left 0), e.g., no flood fill in search unless
+   *              reachable is weighted.
+   */
+  unsigned n = squares.size();
+  double centre = (n - 1) / 2.0;
+
+  for(unsigned f=0; f<num_features; f++) {
+    features[f] = 0;
+    if(only_weighted != 0 && only_weighted->weight[f] == 0)
+      continue;
+
+    switch(f) {
+    case mobility_feature:
+      features[f] = double(count_mobility(squares, own)) -
+	double(count_mobility(squares, opponent));
+      break;
+    case centre_feature: {
+      double own_r = own.row - centre, own_c = own.col - centre;
+      double opp_r = opponent.row - centre, opp_c = opponent.col - centre;
+      double own_distance = std::max(own_r < 0 ? -own_r : own_r,
+				     own_c < 0 ? -own_c : own_c);
+      double opp_distance = std::max(opp_r < 0 ? -opp_r : opp_r,
+				     opp_c < 0 ? -opp_c : opp_c);
+      features[f] = opp_distance - own_distance;
+      break;
+    }
+    case reachable_feature:
+      features[f] = double(count_reachable(squares, own)) -
+	double(count_reachable(squares, opponent));
+      break;
+    }
+  }
+}
+
+
+inline void record_features(const position_record& record,
+			    double features[num_features]) {
+  /*
+   * Description: Features of a packed record for its side to move.
+   */
+  unsigned n = record.board_size;
+  location b(record.black_square / n, record.black_square % n);
+  location w(record.white_square / n, record.white_square % n);
+  packed_squares squares(record);
+
+  if(record.to_move == black)
+    compute_features(squares, b, w, features);
+  else
+    compute_features(squares, w, b, features);
+}
+
+#endif
@@ -6,6 +6,8 @@
  */
 
 #include <iostream>
+#include <sstream> // to_text()
+#include <utility> // move()
 
 #include "isola.h"
 
@@ -22,6 +24,10 @@ isola::isola() : board(7, vector<char>(7, ' ')) {
   // Place pawns.
   board[black_loc.row][black_loc.col] = 'b';
   board[white_loc.row][white_loc.col] = 'w';
+
+  black_mobility = count_mobility(black);
+  white_mobility = count_mobility(white);
+  init_open();
 }
 
 isola::isola(unsigned n) : board(n, vector<char>(n, ' ')) {
@@ -35,6 +41,29 @@ isola::isola(unsigned n) : board(n, vector<char>(n, ' ')) {
   // Place pawns.
   board[black_loc.row][black_loc.col] = 'b';
   board[white_loc.row][white_loc.col] = 'w';
+
+  black_mobility = count_mobility(black);
+  white_mobility = count_mobility(white);
+  init_open();
+}
+
+isola::isola(vector<vector<char> > b) : board(std::move(b)) {
+  // Initialize board size.
+  board_size = board.size();
+
+  // Locate the pawns on the given board.
+  for(unsigned i=0; i<board_size; i++) {
+    for(unsigned j=0; j<board_size; j++) {
+      if(board[i][j] == black)
+	black_loc = location(i, j);
+      else if(board[i][j] == white)
+	white_loc = location(i, j);
+    }
+  }
+
+  black_mobility = count_mobility(black);
+  white_mobility = count_mobility(white);
+  init_open();
 }
 
 void isola::print() {
@@ -74,21 +103,50 @@ location isola::find_player(player p) {
 
 
 void isola::move(player p, direction d, location remove) {
-  location pawn_location = find_player(p);
-  location new_pawn_location = pawn_location;
+  PROFILE_SCOPE(profile_move);
 
   // If the move in direction d cannot be implied throw an exception.
   if(!legal_move(p, d, remove))
     throw "Illegal Move: Illegal Direction";
 
+  step_pawn(p, d);
+  take_square(remove);
+}
+
+void isola::move_pawn(player p, direction d) {
+  // If the move in direction d cannot be implied throw an exception.
+  if(!legal_move(p, d))
+    throw "Illegal Move: Illegal Direction";
+
+  step_pawn(p, d);
+}
+
+void isola::remove_square(location remove) {
+  // If the tile indicated by location remove cannot be removed, throw an
+  // exception.
+  if(!legal_move(remove))
+    throw "Illegal_move: Illegal Tile Removal";
+
+  take_square(remove);
+}
+
+void isola::step_pawn(player p, direction d) {
+  location pawn_location = find_player(p);
+  location new_pawn_location = pawn_location;
+  unsigned& own_mobility = (p == black) ? black_mobility : white_mobility;
+  unsigned& other_mobility = (p == black) ? white_mobility : black_mobility;
+  location other_location = (p == black) ? white_loc : black_loc;
+
   // Empty previous pawn location
   board[pawn_location.row][pawn_location.col] = ' ';
+  add_open(pawn_location.row*board_size + pawn_location.col);
 
   // Compute new pawn location
   new_pawn_location = new_location(p, d);
 
   // Move pawn to next location
   board[new_pawn_location.row][new_pawn_location.col] = p;
+  remove_open(new_pawn_location.row*board_size + new_pawn_location.col);
 
   // Update internal state for pawn's location.
   if(p == black)
@@ -96,15 +154,29 @@ void isola::move(player p, direction d, location remove) {
   else
     white_loc = new_pawn_location;
 
-  // If the tile indicated by location remove cannot be removed, throw an
-  // exception.
-  if(!legal_move(remove))
-    throw "Illegal_move: Illegal Tile Removal";
-  
+  // Only squares next to the pawn's old and new locations changed: the
+  // old square is now free, the new one is now occupied.
+  own_mobility = count_mobility(p);
+  if(adjacent(pawn_location, other_location))
+    other_mobility++;
+  if(adjacent(new_pawn_location, other_location))
+    other_mobility--;
+}
+
+void isola::take_square(location remove) {
   board[remove.row][remove.col] = 'X';
+  remove_open(remove.row*board_size + remove.col);
+
+  // The removed (previously free) square no longer counts as a move.
+  if(adjacent(remove, black_loc))
+    black_mobility--;
+  if(adjacent(remove, white_loc))
+    white_mobility--;
 }
 
 bool isola::legal_move(player p, direction d) {
+  PROFILE_SCOPE(profile_legal_direction);
+
   location pawn_location = find_player(p);
   location new_pawn_location = pawn_location;
 
@@ -132,6 +204,8 @@ bool isola::legal_move(player p, direction d) {
 }
 
 bool isola::legal_move(player p, direction d, location remove) {
+  PROFILE_SCOPE(profile_legal_action);
+
   // Check whether pawn move is legal
   if(!legal_move(p, d))
     return false;
@@ -167,7 +241,74 @@ bool isola::legal_move(location remove) {
 
 
 
+vector<action> isola::legal_actions(player p) {
+  vector<action> actions;
+  location pawn_location = find_player(p);
+
+  // Each legal direction allows every open square (less the destination)
+  // plus the vacated square.
+  actions.reserve(mobility(p) * open_count());
+
+  for(int d=north; d<=southeast; d++) {
+    if(!legal_move(p, direction(d)))
+      continue;
+
+    // Any open square may be removed, as may the square being vacated,
+    // but not the square being moved to.  Visits only open squares, in
+    // row-major order, with the vacated square merged in.
+    location destination = new_location(p, direction(d));
+    unsigned own = pawn_location.row*board_size + pawn_location.col;
+    unsigned target = destination.row*board_size + destination.col;
+    bool own_added = false;
+
+    for(unsigned sq=open.first(); sq<open.size(); sq=open.next(sq + 1)) {
+      if(!own_added && own < sq) {
+	actions.push_back(action(direction(d), pawn_location));
+	own_added = true;
+      }
+      if(sq != target)
+	actions.push_back(action(direction(d),
+				 location(sq / board_size, sq % board_size)));
+    }
+    if(!own_added)
+      actions.push_back(action(direction(d), pawn_location));
+  }
+
+  return actions;
+}
+
+
+unsigned isola::direction_mask(player p) {
+  unsigned mask = 0;
+
+  for(int d=north; d<=southeast; d++)
+    if(legal_move(p, direction(d)))
+      mask |= 1 << d;
+  return mask;
+}
+
+
+action isola::random_action(player p, mt19937& rng) {
+  unsigned mask = direction_mask(p);
+
+  // The k-th legal direction, for uniform k.
+  unsigned k = uniform_int_distribution<unsigned>(0, mobility(p) - 1)(rng);
+  for(; k>0; k--)
+    mask &= mask - 1;
+  direction d = direction(__builtin_ctz(mask));
+
+  location remove =
+    open_square(uniform_int_distribution<unsigned>(0, open_size - 1)(rng));
+  if(remove == new_location(p, d))
+    remove = find_player(p);
+
+  return action(d, remove);
+}
+
+
 location isola::new_location(player p, direction d) {
+  PROFILE_SCOPE(profile_new_location);
+
   //Find current location
   location pawn_location = find_player(p);
   location new_pawn_location = pawn_location;
@@ -232,16 +373,219 @@ vector<vector<char> > isola::current_board() {
 
 
 bool isola::lost_game(player p) {
-  if(!legal_move(p, north) &&
-     !legal_move(p, south) &&
-     !legal_move(p, east) &&
-     !legal_move(p, west) &&
-     !legal_move(p, northwest) &&
-     !legal_move(p, northeast) &&
-     !legal_move(p, southwest) &&
-     !legal_move(p, southeast)) {
-    // No moves are possible
-    return true;
+  // No moves are possible
+  return mobility(p) == 0;
+}
+
+
+unsigned isola::mobility(player p) {
+  if(p == black)
+    return black_mobility;
+  return white_mobility;
+}
+
+
+game_outcome isola::game_result() {
+  PROFILE_SCOPE(profile_game_result);
+
+  if(black_mobility == 0 && white_mobility == 0)
+    return tied;
+  if(black_mobility == 0)
+    return white_won;
+  if(white_mobility == 0)
+    return black_won;
+  return playing;
+}
+
+
+unsigned isola::count_mobility(player p) {
+  unsigned count = 0;
+
+  for(int d=north; d<=southeast; d++)
+    if(legal_move(p, direction(d)))
+      count++;
+  return count;
+}
+
+
+unsigned isola::open_count() {
+  return open_size;
+}
+
+
+location isola::open_square(unsigned i) {
+  return location(open_list[i] / board_size, open_list[i] % board_size);
+}
+
+
+const bitboard& isola::open_squares() {
+  return open;
+}
+
+
+string isola::to_text(player to_move) {
+  ostringstream text;
+
+  for(unsigned i=0; i<board_size; i++) {
+    unsigned open_run = 0;
+    if(i > 0)
+      text << '/';
+
+    for(unsigned j=0; j<board_size; j++) {
+      if(board[i][j] == ' ') {
+	open_run++;
+	continue;
+      }
+      if(open_run > 0)
+	text << open_run;
+      open_run = 0;
+      text << (board[i][j] == 'X' ? 'x' : board[i][j]);
+    }
+    if(open_run > 0)
+      text << open_run;
   }
-  return false;
+
+  text << ' ' << (to_move == white ? 'w' : 'b');
+  return text.str();
+}
+
+
+bool isola::from_text(const string& text, isola& board, player& to_move) {
+  vector<vector<char> > cells(1);
+  unsigned pawns[2] = {0, 0};
+  size_t i = 0;
+
+  // Rows, as runs of squares.
+  for(; i<text.size() && text[i] != ' '; i++) {
+    char c = text[i];
+    if(c == '/')
+      cells.push_back(vector<char>());
+    else if(c >= '0' && c <= '9') {
+      // Rejected as soon as it is too long, before it can overflow.
+      unsigned run = 0;
+      for(; i<text.size() && text[i] >= '0' && text[i] <= '9'; i++) {
+	run = run*10 + (text[i] - '0');
+	if(run > 255)
+	  return false;
+      }
+      i--;
+      cells.back().insert(cells.back().end(), run, ' ');
+    }
+    else if(c == 'x' || c == 'X')
+      cells.back().push_back('X');
+    else if(c == 'b' || c == 'w') {
+      pawns[c == 'w']++;
+      cells.back().push_back(c);
+    }
+    else
+      return false;
+  }
+
+  // Square, at most 255x255 (16-bit square numbers), one pawn each.
+  unsigned n = cells.size();
+  if(n < 2 || n > 255 || pawns[0] != 1 || pawns[1] != 1)
+    return false;
+  for(unsigned row=0; row<n; row++)
+    if(cells[row].size() != n)
+      return false;
+
+  // Side to move.
+  while(i < text.size() && text[i] == ' ')
+    i++;
+  if(i >= text.size() || (text[i] != 'b' && text[i] != 'w'))
+    return false;
+  for(size_t rest=i+1; rest<text.size(); rest++)
+    if(text[rest] != ' ' && text[rest] != '\r' && text[rest] != '\n')
+      return false;
+
+  to_move = text[i] == 'w' ? white : black;
+  board = isola(cells);
+  return true;
+}
+
+
+void isola::to_binary(player to_move, vector<unsigned char>& out) {
+  unsigned n = board_size;
+  unsigned b = black_loc.row*n + black_loc.col;
+  unsigned w = white_loc.row*n + white_loc.col;
+  size_t start = out.size();
+
+  out.resize(start + binary_size(n), 0);
+  unsigned char* data = &out[start];
+  data[0] = n;
+  data[1] = b & 0xff;
+  data[2] = b >> 8;
+  data[3] = w & 0xff;
+  data[4] = w >> 8;
+  data[5] = to_move == white;
+
+  for(unsigned square=0; square<n*n; square++)
+    if(board[square / n][square % n] == 'X')
+      data[6 + square/8] |= 1 << (square % 8);
+}
+
+
+unsigned isola::from_binary(const unsigned char* data, unsigned size,
+			    isola& board, player& to_move) {
+  if(size < 1)
+    return 0;
+
+  unsigned n = data[0];
+  if(n < 2 || size < binary_size(n))
+    return 0;
+
+  unsigned b = data[1] | (data[2] << 8);
+  unsigned w = data[3] | (data[4] << 8);
+  if(b >= n*n || w >= n*n || b == w || data[5] > 1)
+    return 0;
+
+  vector<vector<char> > cells(n, vector<char>(n, ' '));
+  for(unsigned square=0; square<n*n; square++)
+    if((data[6 + square/8] >> (square % 8)) & 1)
+      cells[square / n][square % n] = 'X';
+  cells[b / n][b % n] = black;
+  cells[w / n][w % n] = white;
+
+  to_move = data[5] ? white : black;
+  board = isola(cells);
+  return binary_size(n);
+}
+
+
+void isola::init_open() {
+  open = bitboard(board_size * board_size);
+  open_list.resize(board_size * board_size);
+  open_position.resize(board_size * board_size);
+  open_size = 0;
+
+  for(unsigned i=0; i<board_size; i++) {
+    const char* row = &board[i][0];
+    for(unsigned j=0; j<board_size; j++)
+      if(row[j] == ' ')
+	add_open(i*board_size + j);
+  }
+}
+
+
+void isola::add_open(unsigned square) {
+  open.set(square);
+  open_position[square] = open_size;
+  open_list[open_size++] = square;
+}
+
+
+void isola::remove_open(unsigned square) {
+  // Swap the last square into the removed one's place.
+  unsigned last = open_list[--open_size];
+  open_list[open_position[square]] = last;
+  open_position[last] = open_position[square];
+  open.reset(square);
+}
+
+
+bool isola::adjacent(location a, location b) {
+  unsigned row_distance = a.row > b.row ? a.row - b.row : b.row - a.row;
+  unsigned col_distance = a.col > b.col ? a.col - b.col : b.col - a.col;
+
+  return row_distance <= 1 && col_distance <= 1 && !(a == b);
 }
@@ -9,8 +9,12 @@
 #ifndef ISOLA_H
 #define ISOLA_H
 
-#include <vector>  // The game board is a 2D vector
-#include "types.h" // Types associated with the game/tournament
+#include <random>     // random_action()
+#include <string>     // Text positions
+#include <vector>     // The game board is a 2D vector
+#include "bitboard.h" // Open squares
+#include "profile.h"  // Optional hot-path counters
+#include "types.h"    // Types associated with the game/tournament
 
 
 class isola {
@@ -18,22 +22,57 @@ class isola {
    * Description: Manages the logic for the game isola.
    */
  private:
+#ifdef ISOLA_PROFILE
+  profile_copy_begin copy_begin; // Times copies: keep before the data
+#endif
   unsigned board_size;
   std::vector<std::vector<char> > board;
   location black_loc, white_loc;
 
-  bool legal_move(location remove); 
+  // Number of legal pawn moves (directions) for each player, kept up to
+  // date by move() so that lost_game()/mobility() are O(1).
+  unsigned black_mobility, white_mobility;
+
+  // Open squares (' ': neither removed nor occupied), also kept up to date
+  // by move(), in two forms: a bitboard for in-order iteration that skips
+  // removed regions, and an unordered list (its first open_size entries,
+  // plus each square's position in it) for O(1) indexing, insertion and
+  // removal.  Squares are numbered row*n + col; 16 bits (boards up to
+  // 255x255) keep board copies small.
+  bitboard open;
+  std::vector<unsigned short> open_list;
+  std::vector<unsigned short> open_position;
+  unsigned open_size;
+#ifdef ISOLA_PROFILE
+  profile_copy_end copy_end;     // and after it.
+#endif
+
+  void init_open();
   /*
-   * Description: Checks whether the removal of location remove is a legal
-   *              second-half of a move.
-   * 
-   * Preconditions: In general, this version of legal_move is to be called
-   *                after the pawn's move has been applied.
-   *
-   * Notes: (For efficiency) Considers only the removal, assuming _half_ of 
-   *        the current move has already been applied (the pawn's movement).
-   *        Because there is no interface to apply only half of a move (the
-   *        pawn's movement) this method is for internal use only.
+   * Description: Builds the open square structures from the board.
+   */
+
+  void add_open(unsigned square);
+  void remove_open(unsigned square);
+
+  void step_pawn(player p, direction d);
+  void take_square(location remove);
+  /*
+   * Description: The two halves of a move, without legality checks:
+   *              moves p's pawn in direction d / removes square remove,
+   *              updating the cached mobility and open squares.
+   */
+
+  unsigned count_mobility(player p);
+  /*
+   * Description: Counts p's legal pawn moves by checking all 8 directions.
+   *              Used to (re)initialize the cached mobility.
+   */
+
+  static bool adjacent(location a, location b);
+  /*
+   * Description: Checks whether a and b are neighbours (one step apart
+   *              in any of the 8 directions).
    */
   
  public:
@@ -49,6 +88,13 @@ class isola {
    *              and south ends.
    */
 
+  isola(std::vector<std::vector<char> > b);
+  /*
+   * Description: Initialize an isola board from an existing (square) board
+   *              configuration, e.g., one returned by current_board().
+   *              Pawn locations are found by searching b for 'b' and 'w'.
+   */
+
   void print();
   /*
    * Description: Prints the current game board configuration to the terminal.
@@ -60,8 +106,35 @@ class isola {
    * Postconditions: If the move is legal it has been applied.  If the
    *                  move was illegal (bad direction or bad remove) then
    *                  an exception is thrown.
+   *
+   * Notes: Updates both players' cached mobility using only the squares
+   *        next to the pawn's old/new locations and the removed square.
    */
   
+  void move_pawn(player p, direction d);
+  /*
+   * Description: Applies only the first half of a move: p's pawn steps in
+   *              direction d.  The square it left is open, so it can be
+   *              removed by the second half (remove_square()).
+   * Postconditions: If legal_move(p, d), the pawn has moved.  Otherwise
+   *                 an exception is thrown.
+   *
+   * Notes: Together with remove_square() this lets a search treat the
+   *        direction and the removal as two half-plies of the same player
+   *        (e.g., to order, prune or gather statistics per direction).
+   *        move_pawn(p, d) then remove_square(remove) leaves the board
+   *        exactly as move(p, d, remove) does.  Until the removal, the
+   *        board (and its mobility) is the half-moved position.
+   */
+
+  void remove_square(location remove);
+  /*
+   * Description: Applies the second half of a move: removes square
+   *              remove.
+   * Postconditions: If legal_move(remove), the square has been removed.
+   *                 Otherwise an exception is thrown.
+   */
+
   location find_player(player p);
   /*
    * Description: Returns p's location on the game board as specified by
@@ -104,6 +177,53 @@ class isola {
    */
 
 
+  bool legal_move(location remove);
+  /*
+   * Description: Checks whether the removal of location remove is a legal
+   *              second-half of a move.
+   *
+   * Preconditions: In general, this version of legal_move is to be called
+   *                after the pawn's move has been applied (move_pawn()).
+   *
+   * Notes: (For efficiency) Considers only the removal, assuming _half_ of
+   *        the current move has already been applied (the pawn's movement).
+   *        After move_pawn() the legal removals are exactly the open
+   *        squares (open_squares()), the square just vacated included.
+   */
+
+
+  std::vector<action> legal_actions(player p);
+  /*
+   * Description: Generates every legal action (direction, removal) for p.
+   *
+   * Returns:
+   *     All actions for which legal_move(p, d, remove) is true, ordered by
+   *     direction, then removal row, then removal column.
+   */
+
+
+  unsigned direction_mask(player p);
+  /*
+   * Description: Returns p's legal pawn moves as a bit mask: bit d is set
+   *              if legal_move(p, d).
+   */
+
+
+  action random_action(player p, std::mt19937& rng);
+  /*
+   * Description: Draws a uniformly random action from legal_actions(p), in
+   *              O(1) time whatever the board size or number of removed
+   *              squares (no rejection sampling, no move list).
+   *
+   * Preconditions: p has a legal move (mobility(p) > 0).
+   *
+   * Notes: Every legal direction allows the same number of removals
+   *        (the open squares, with the destination swapped for the square
+   *        being vacated), so a uniform direction followed by a uniform
+   *        removal is uniform over actions.
+   */
+
+
   location new_location(player p, direction d);
   /*
    * Description: Computes the new location of p after a move has been
@@ -147,6 +267,9 @@ class isola {
    * Returns:
    *     A copy of the requested row of the game board.
    *
+   * Note: Writing to the board through this reference bypasses move(), so
+   *       the cached mobility (lost_game(), mobility()) and open squares
+   *       are not updated.
    */
 
   
@@ -180,8 +303,94 @@ class isola {
    *     false - p can still legally move in one of: N/S/E/W/NW/NE/SW/SE.
    * 
    * Note: A returned value of false may imply either the other player's
-   *       victory _or_ that a tie has occurred.
+   *       victory _or_ that a tie has occurred.  O(1) (uses the cached
+   *       mobility).
+   */
+
+  unsigned mobility(player p);
+  /*
+   * Description: Returns the number of directions p can legally move in
+   *              (0-8).  O(1).
+   */
+
+  unsigned open_count();
+  /*
+   * Description: Returns the number of open squares (neither removed nor
+   *              occupied by a pawn).  O(1).
+   */
+
+  location open_square(unsigned i);
+  /*
+   * Description: Returns open square i, for 0 <= i < open_count().  O(1).
+   *
+   * Note: The order is arbitrary and changes when a move is made, but
+   *       each open square appears exactly once (e.g., open_square(r)
+   *       for a uniformly random r is a uniformly random open square).
+   */
+
+  const bitboard& open_squares();
+  /*
+   * Description: Returns the open squares as a bitboard (square
+   *              row*n + col), for iterating them in row-major order
+   *              without visiting removed squares.
+   */
+
+  game_outcome game_result();
+  /*
+   * Description: Reports the state of the game in a single call.
+   *
+   * Returns:
+   *     playing   - Both players can still move.
+   *     black_won - Only white has no legal moves.
+   *     white_won - Only black has no legal moves.
+   *     tied      - Neither player has a legal move.
    */
+
+  std::string to_text(player to_move);
+  /*
+   * Description: Encodes the position (board and side to move) as text,
+   *              in the manner of chess FEN: rows from row 0, separated by
+   *              '/', each a run of squares where a number counts open
+   *              squares, 'x' is a removed square and 'b'/'w' the pawns;
+   *              then a space and the side to move ('b' or 'w').  E.g.,
+   *              the 7x7 start position, black to move, is
+   *                  3b3/7/7/7/7/7/3w3 b
+   */
+
+  static bool from_text(const std::string& text, isola& board,
+			player& to_move);
+  /*
+   * Description: Decodes a position written by to_text() into board and
+   *              to_move.
+   *
+   * Returns:
+   *     false - text is not a valid position (rows of unequal length, a
+   *             board that is not square, or not exactly one pawn of each
+   *             color).  board and to_move are unchanged.
+   */
+
+  void to_binary(player to_move, std::vector<unsigned char>& out);
+  /*
+   * Description: Appends the position in binary to out: board size n
+   *              (u8), black square and white square (u16 each, square =
+   *              row*n + col, little-endian), side to move (u8: 0 black,
+   *              1 white), then the removed squares as a bitmap (bit
+   *              square%8 of byte square/8), 6 + ceil(n*n/8) bytes in
+   *              all.
+   */
+
+  static unsigned from_binary(const unsigned char* data, unsigned size,
+			      isola& board, player& to_move);
+  /*
+   * Description: Decodes one position written by to_binary() from the
+   *              size bytes at data.
+   *
+   * Returns:
+   *     The number of bytes read, or 0 if data does not hold a complete,
+   *     valid position (board and to_move are then unchanged).
+   */
+
+  static unsigned binary_size(unsigned n) { return 6 + (n*n + 7) / 8; }
 };
 
 #endif
@@ -0,0 +1,256 @@
+/*
+ * File: league.h
+ * Author: Joshua T. Guerin
+ * Purpose: Runs a round-robin league between every agent in an agent_list
+ *          (see agents/agents.h) and reports a crosstable with Elo
+ *          estimates.
+ *
+ * Note: Like tournament.h this is a templated class, so there is no
+ *       league.cpp.  Individual games are played by tournament objects
+ *       and scheduled on a work-stealing thread_pool.  Game k of the
+ *       schedule is seeded with base seed + k (the base seed is drawn
+ *       from rand() once, before any game starts), so the crosstable
+ *       depends only on --seed, not on the threads.
+ */
+
+#ifndef LEAGUE_H
+#define LEAGUE_H
+
+#include <cstdio>   // snprintf()
+#include <cstdlib>  // rand()
+#include <iomanip>  // setw()
+#include <iostream> // Console io
+#include <mutex>    // Result tallies are shared between workers
+#include <string>   // Agent names
+#include <vector>   // Crosstable
+
+#include "elo.h"         // Elo/confidence interval reporting
+#include "thread_pool.h" // Parallel game scheduling
+#include "tournament.h"  // Plays individual games
+#include "types.h"       // agent_list, round_winner
+
+
+template <typename TAgentList>
+class league;
+
+template <typename... TAgents>
+class league<agent_list<TAgents...> > {
+  /*
+   * League class: Plays every pairing of the listed agents with both
+   *               color assignments, num_games times each, in parallel.
+   */
+ private:
+  typedef round_winner (*game_function)(unsigned grid_size, unsigned seed);
+
+  // Simulation flags/data
+  unsigned games_per_color;
+  unsigned board_size;
+  unsigned num_threads;
+
+  // game_table[b][w] plays one game with agent b as black, w as white.
+  std::vector<std::vector<game_function> > game_table;
+  std::vector<std::string> names;
+
+  // results[i][j] is agent i's record against agent j.
+  std::vector<std::vector<match_score> > results;
+  std::mutex results_lock;
+
+  template <typename TBlackAgent, typename TWhiteAgent>
+  static round_winner play_game(unsigned grid_size, unsigned seed);
+  /*
+   * Description: Plays a single silent game of isola between
+   *              TBlackAgent and TWhiteAgent, seeded with seed (see
+   *              tournament::run_simulation()).
+   */
+
+  template <typename TBlackAgent>
+  static std::vector<game_function> game_row();
+  /*
+   * Description: Returns play_game<TBlackAgent, T> for every agent T.
+   */
+
+  template <typename TAgent>
+  static std::string agent_name();
+  /*
+   * Description: Constructs TAgent only to get its name for the report.
+   */
+
+  void record_game(unsigned b, unsigned w, const round_winner& winner);
+  /*
+   * Description: Adds a finished game's result to both agents' records.
+   */
+
+  void print_crosstable();
+  /*
+   * Description: Prints pairwise scores, total score, and Elo estimates
+   *              relative to the league average.
+   */
+
+ public:
+  league(unsigned num_games, unsigned grid_size, unsigned threads);
+  /*
+   * Description: Constructs a league where each ordered pairing (black,
+   *              white) of distinct agents is played num_games times on
+   *              a grid_size board, using threads worker threads.
+   */
+
+  void run();
+  /*
+   * Description: Plays every game of the league and prints the crosstable.
+   */
+};
+
+
+template <typename... TAgents>
+league<agent_list<TAgents...> >::league(unsigned num_games,
+					 unsigned grid_size,
+					 unsigned threads)
+  : game_table{ game_row<TAgents>()... },
+    names{ agent_name<TAgents>()... } {
+  games_per_color = num_games;
+  board_size = grid_size;
+  num_threads = threads;
+}
+
+
+template <typename... TAgents>
+template <typename TBlackAgent, typename TWhiteAgent>
+round_winner league<agent_list<TAgents...> >::play_game(unsigned grid_size,
+							 unsigned seed) {
+  tournament<TBlackAgent, TWhiteAgent> game(1, false, false, false,
+					    grid_size);
+  return game.run_simulation(seed, false);
+}
+
+
+template <typename... TAgents>
+template <typename TBlackAgent>
+std::vector<round_winner (*)(unsigned, unsigned)>
+league<agent_list<TAgents...> >::game_row() {
+  return std::vector<game_function>{ &play_game<TBlackAgent, TAgents>... };
+}
+
+
+template <typename... TAgents>
+template <typename TAgent>
+std::string league<agent_list<TAgents...> >::agent_name() {
+  TAgent agent(black);
+  return agent.name();
+}
+
+
+template <typename... TAgents>
+void league<agent_list<TAgents...> >::run() {
+  unsigned num_agents = names.size();
+  results.assign(num_agents, std::vector<match_score>(num_agents));
+
+  // Workers never touch rand(): each game gets its own seed up front.
+  unsigned base_seed = rand();
+  unsigned game_index = 0;
+
+  {
+    thread_pool pool(num_threads);
+
+    // Each game is its own task; idle workers steal from busy ones so
+    // pairings with slow agents don't hold up the league.
+    for(unsigned b=0; b<num_agents; b++) {
+      for(unsigned w=0; w<num_agents; w++) {
+	if(b == w)
+	  continue;
+
+	for(unsigned i=0; i<games_per_color; i++) {
+	  game_function game = game_table[b][w];
+	  unsigned grid_size = board_size;
+	  unsigned seed = base_seed + game_index++;
+	  pool.submit([this, game, grid_size, seed, b, w]() {
+	      record_game(b, w, game(grid_size, seed));
+	    });
+	}
+      }
+    }
+
+    pool.wait();
+  }
+
+  print_crosstable();
+}
+
+
+template <typename... TAgents>
+void league<agent_list<TAgents...> >::record_game(unsigned b, unsigned w,
+						   const round_winner& winner) {
+  std::lock_guard<std::mutex> guard(results_lock);
+
+  if(winner.black && winner.white) {
+    results[b][w].ties++;
+    results[w][b].ties++;
+  }
+  else if(winner.black) {
+    results[b][w].wins++;
+    results[w][b].losses++;
+  }
+  else {
+    results[b][w].losses++;
+    results[w][b].wins++;
+  }
+}
+
+
+template <typename... TAgents>
+void league<agent_list<TAgents...> >::print_crosstable() {
+  unsigned num_agents = names.size();
+  unsigned name_width = 5;
+  char buffer[64];
+
+  for(unsigned i=0; i<num_agents; i++)
+    if(names[i].size() > name_width)
+      name_width = names[i].size();
+
+  std::cout << bold << "Generating league report..." << regular << std::endl
+	    << bold << "Agents: " << regular << num_agents
+	    << bold << "  Games per pairing: " << regular
+	    << 2*games_per_color
+	    << bold << "  Board: " << regular
+	    << board_size << 'x' << board_size << std::endl << std::endl;
+
+  // Header row: opponent numbers, then totals.
+  std::cout << bold << std::setw(4) << "#" << "  " << std::left
+	    << std::setw(name_width) << "Agent" << std::right;
+  for(unsigned j=0; j<num_agents; j++)
+    std::cout << std::setw(12) << j+1;
+  std::cout << std::setw(14) << "Score" << std::setw(9) << "Elo"
+	    << std::setw(20) << "95% CI" << regular << std::endl;
+
+  for(unsigned i=0; i<num_agents; i++) {
+    match_score total;
+
+    std::cout << std::setw(4) << i+1 << "  " << std::left
+	      << std::setw(name_width) << names[i] << std::right;
+
+    for(unsigned j=0; j<num_agents; j++) {
+      if(i == j) {
+	std::cout << std::setw(12) << "-";
+	continue;
+      }
+      snprintf(buffer, sizeof(buffer), "%g/%u",
+	       results[i][j].points(), results[i][j].games());
+      std::cout << std::setw(12) << buffer;
+      total += results[i][j];
+    }
+
+    double low, high;
+    elo_interval(total, low, high);
+
+    snprintf(buffer, sizeof(buffer), "%g/%u", total.points(), total.games());
+    std::cout << std::setw(14) << buffer;
+    snprintf(buffer, sizeof(buffer), "%+.0f", elo_from_score(total.score()));
+    std::cout << std::setw(9) << buffer;
+    snprintf(buffer, sizeof(buffer), "[%+.0f, %+.0f]", low, high);
+    std::cout << std::setw(20) << buffer << std::endl;
+  }
+  std::cout << std::endl
+	    << "Elo is relative to the league average; ties count half."
+	    << std::endl;
+}
+
+#endif
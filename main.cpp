@@ -13,6 +13,7 @@
 #include <getopt.h>  // getopt()
 #include <cstdlib>   // atoi()
 #include <algorithm> // remove()
+#include <cstdio>    // sscanf()
 
 // Simulation Flags
 bool output_moves=false;
@@ -20,18 +21,36 @@ bool pause_between_moves=false;
 bool display_winner=true;
 unsigned num_simulations=1;
 unsigned grid_size=7;
+bool league_play=false;
+unsigned num_threads=0; // 0: one per hardware thread
+std::string black_agent, white_agent; // Runtime agent selection
+std::string plugin_directory="plugins";
+bool list_agents=false;
+bool use_sprt=false;     // Early stopping (--sprt)
+double sprt_elo0=0, sprt_elo1=5, sprt_alpha=0.05, sprt_beta=0.05;
+bool paired_games=false; // Colors swapped per seed (--paired)
+bool pondering=false;    // Agents think on the opponent's time (--ponder)
+bool factored_search=false; // MCTS moves as two half-plies (--factored)
+unsigned opening_plies=0;
+unsigned seed=time(NULL);
+std::string network_file; // Network evaluation for search agents
+std::string weights_file; // Tuned evaluation weights for search agents
+std::string checkpoint_file; // Tournament state, written as it runs
+unsigned checkpoint_interval=100;
+std::string resume_file;     // Tournament state to continue from
 
 #include "tournament.h" // Templated class that runs an isola tournament.
+#include "league.h"     // Templated class that runs a round-robin league.
+#include "registry.h"   // Agents selected at runtime/loaded from plugins.
 #include "types.h"      // Types associated with game/tournament.
 
 /*
  * Agents to play the game.
- * Notes: Include any additional agents here.
+ * Notes: Include any additional agents in agents/agents.h.
  *        Agents that are included but not used to instantiate a tournament
- *        object are effectively ignored.
+ *        object are still played in league mode (-l).
  */
-#include "agents/random_agent.h"
-#include "agents/ordered_agent.h"
+#include "agents/agents.h"
 
 
 using namespace std;
@@ -46,6 +65,14 @@ void parse_args(int argc, char *argv[]);
  */
 
 
+template <typename TTournament>
+void configure(TTournament& tourney);
+/*
+ * Description: Applies the optional tournament flags (SPRT, paired
+ *              scheduling, openings, pondering, checkpoints) to tourney.
+ */
+
+
 void help(string binary_name, string options);
 /*
  * Description: Prints usage message if -h or --help flags arguments
@@ -54,15 +81,83 @@ void help(string binary_name, string options);
 
 
 int main(int argc, char *argv[]) {
-  srand(time(NULL));
-  
   parse_args(argc, argv);
+  srand(seed);
+
+  // The MCTS agent expands a move as a direction, then a removal.
+  mcts_agent::agent::set_factored(factored_search);
+
+  // Search agents evaluate with the network instead of mobility.
+  nnue_network network;
+  if(!network_file.empty()) {
+    if(!network.load(network_file)) {
+      cerr << "Error: Could not load network " << network_file << "." << endl;
+      return 1;
+    }
+    alphabeta_agent::agent::set_network(&network);
+  }
+
+  // Tuned weights are read by each search agent as it is constructed.
+  if(!weights_file.empty()) {
+    eval_weights weights;
+    if(!weights.load(weights_file)) {
+      cerr << "Error: Could not load weights " << weights_file << "." << endl;
+      return 1;
+    }
+    alphabeta_agent::agent::set_weights_file(weights_file);
+  }
+
+  // League play: every agent in agents/agents.h plays every other.
+  if(league_play) {
+    league<all_agents> round_robin(num_simulations, grid_size,
+				   num_threads ? num_threads :
+				   thread_pool::default_threads());
+    round_robin.run();
+    return 0;
+  }
   
+  // Runtime agent selection: built-in agents plus any plugins.
+  if(!black_agent.empty() || !white_agent.empty() || list_agents) {
+    agent_registry registry;
+    registry.add(all_agents());
+    registry.load_directory(plugin_directory);
+
+    if(list_agents) {
+      registry.list();
+      return 0;
+    }
+
+    agent_entry* black_entry =
+      registry.find(black_agent.empty() ? "random_agent" : black_agent);
+    agent_entry* white_entry =
+      registry.find(white_agent.empty() ? "ordered_agent" : white_agent);
+    if(black_entry == 0 || white_entry == 0) {
+      cerr << "Error: Unknown agent '"
+	   << (black_entry == 0 ? black_agent : white_agent) << "'." << endl
+	   << "See the --list-agents option for available agents." << endl;
+      return 1;
+    }
+    runtime_agent::select(0, black_entry);
+    runtime_agent::select(1, white_entry);
+
+    {
+      tournament<selected_agent<0>, selected_agent<1> >
+	tourney(num_simulations, output_moves, pause_between_moves,
+		display_winner, grid_size);
+      configure(tourney);
+      tourney.run();
+    }
+
+    registry.print_call_stats();
+    return 0;
+  }
+
   // You can change random_agent::agent or ordered_agent::agent
   // to initialize any two agents of your own design or mine for testing.
   tournament<random_agent::agent, ordered_agent::agent>
     tourney(num_simulations, output_moves, pause_between_moves,
 	    display_winner, grid_size);
+  configure(tourney);
 
   // Run tournament
   tourney.run();
@@ -71,17 +166,53 @@ int main(int argc, char *argv[]) {
 }
 
 
+template <typename TTournament>
+void configure(TTournament& tourney) {
+  if(use_sprt)
+    tourney.use_sprt(sprt(sprt_elo0, sprt_elo1, sprt_alpha, sprt_beta));
+  if(paired_games)
+    tourney.use_paired_games();
+  tourney.set_opening_plies(opening_plies);
+  if(pondering)
+    tourney.use_pondering();
+  if(!checkpoint_file.empty())
+    tourney.use_checkpoints(checkpoint_file, checkpoint_interval);
+  if(!resume_file.empty() && !tourney.resume(resume_file)) {
+    cerr << "Error: Could not resume from " << resume_file
+	 << " (unreadable, or saved with other agents or settings)." << endl;
+    exit(1);
+  }
+}
+
+
 void parse_args(int argc, char *argv[]) {
   int option;
   char *cvalue = NULL;
   opterr = 0;
 
   // getopt_long arguments
-  string options = "g:hops:w";
+  string options = "g:hj:lops:w";
   const struct option long_options[] =
     {
+      {"black",       required_argument,  0, 'B'},
+      {"white",       required_argument,  0, 'W'},
+      {"plugins",     required_argument,  0, 'P'},
+      {"list-agents", no_argument,        0, 'L'},
+      {"sprt",        required_argument,  0, 'S'},
+      {"paired",      no_argument,        0, 'R'},
+      {"ponder",      no_argument,        0, 'T'},
+      {"factored",    no_argument,        0, 'F'},
+      {"checkpoint",  required_argument,  0, 'C'},
+      {"checkpoint-every", required_argument, 0, 'K'},
+      {"resume",      required_argument,  0, 'U'},
+      {"openings",    required_argument,  0, 'O'},
+      {"seed",        required_argument,  0, 'D'},
+      {"network",     required_argument,  0, 'N'},
+      {"weights",     required_argument,  0, 'E'},
       {"grid",        required_argument,  0, 'g'},
       {"help",        no_argument,        0, 'h'},
+      {"threads",     required_argument,  0, 'j'},
+      {"league",      no_argument,        0, 'l'},
       {"output",      no_argument,        0, 'o'},
       {"pause",       no_argument,        0, 'p'},
       {"simulations", required_argument,  0, 's'},
@@ -96,6 +227,71 @@ void parse_args(int argc, char *argv[]) {
   
   while(option != -1) {
     switch(option) {
+    case 'B':
+      // Runtime-selected black agent (long option only)
+      black_agent = optarg;
+      break;
+    case 'W':
+      // Runtime-selected white agent (long option only)
+      white_agent = optarg;
+      break;
+    case 'P':
+      // Directory of agent plugins (long option only)
+      plugin_directory = optarg;
+      break;
+    case 'L':
+      // List runtime-selectable agents (long option only)
+      list_agents = true;
+      break;
+    case 'R':
+      // Paired scheduling (long option only)
+      paired_games = true;
+      break;
+    case 'T':
+      // Pondering (long option only)
+      pondering = true;
+      break;
+    case 'F':
+      // Factored (two half-ply) search (long option only)
+      factored_search = true;
+      break;
+    case 'C':
+      // Checkpoint file (long option only)
+      checkpoint_file = optarg;
+      break;
+    case 'K':
+      // Games between checkpoints (long option only)
+      checkpoint_interval = atoi(optarg);
+      break;
+    case 'U':
+      // Continue from a checkpoint (long option only)
+      resume_file = optarg;
+      break;
+    case 'O':
+      // Random opening length (long option only)
+      opening_plies = atoi(optarg);
+      break;
+    case 'D':
+      // Seed for rand() (long option only)
+      seed = strtoul(optarg, NULL, 10);
+      break;
+    case 'N':
+      // Network file for search agents (long option only)
+      network_file = optarg;
+      break;
+    case 'E':
+      // Evaluation weights file for search agents (long option only)
+      weights_file = optarg;
+      break;
+    case 'S':
+      // SPRT early stopping: elo0,elo1[,alpha,beta] (long option only)
+      use_sprt = true;
+      if(sscanf(optarg, "%lf,%lf,%lf,%lf", &sprt_elo0, &sprt_elo1,
+		&sprt_alpha, &sprt_beta) < 2) {
+	cerr << "Error: --sprt expects elo0,elo1[,alpha,beta]." << endl;
+	exit(0);
+      }
+      break;
     case 'g':
       // Grid size flag
       cvalue = optarg;
@@ -106,6 +302,15 @@ void parse_args(int argc, char *argv[]) {
       help(argv[0], options);
       exit(0);
       break;
+    case 'j':
+      // Number of worker threads for league play
+      cvalue = optarg;
+      num_threads = atoi(cvalue);
+      break;
+    case 'l':
+      // Round-robin league between all registered agents
+      league_play = true;
+      break;
     case 'o':
       // Output individual moves
       output_moves = true;
@@ -125,7 +330,7 @@ void parse_args(int argc, char *argv[]) {
       display_winner = false;
       break;
     case '?':
-      if(optopt == 'g' || optopt == 's') {
+      if(optopt == 'g' || optopt == 'j' || optopt == 's') {
 	cerr << "Error: Option -"<< char(optopt)
 	     <<" requires an argument." << endl;
       }
@@ -159,6 +364,50 @@ void help(string binary_name, string options) {
        << "         Sets gameboard size to " << bold << 'n' << regular << 'x' << bold << 'n' << regular << '.' << endl
        << bold << "-h | --help" << regular
        << "           Print this help." << endl
+       << bold << "-j | --threads n" << regular
+       << "      Uses " << bold << 'n' << regular << " worker threads for league play (default: all" << endl
+       << "                      hardware threads)." << endl
+       << bold << "-l | --league" << regular
+       << "         Plays a round-robin league between every agent in" << endl
+       << "                      agents/agents.h, " << bold << "n" << regular << " games (-s) per pairing and" << endl
+       << "                      color, and prints a crosstable with Elo estimates." << endl
+       << bold << "--black name, --white name" << endl << regular
+       << "                      Chooses agents at runtime, from the built-in agents or" << endl
+       << "                      agent plugins (see --plugins)." << endl
+       << bold << "--plugins dir" << regular
+       << "         Loads agent plugins (*.so) from " << bold << "dir" << regular << " (default: plugins)." << endl
+       << bold << "--list-agents" << regular
+       << "         Lists the agents available to --black/--white." << endl
+       << bold << "--sprt elo0,elo1[,alpha,beta]" << endl << regular
+       << "                      Stops as soon as a sequential probability ratio test" << endl
+       << "                      accepts H0 (black is elo0 stronger) or H1 (elo1)." << endl
+       << "                      -s becomes the maximum number of games." << endl
+       << "                      alpha and beta default to 0.05." << endl
+       << bold << "--paired" << regular
+       << "              Plays every seed (first move and opening) twice, with" << endl
+       << "                      the agents' colors swapped, and reports paired" << endl
+       << "                      statistics." << endl
+       << bold << "--openings n" << regular
+       << "          Starts each game from " << bold << 'n' << regular << " random legal moves." << endl
+       << bold << "--ponder" << regular
+       << "              Agents that support it keep searching during the" << endl
+       << "                      opponent's turn (games are no longer reproducible)." << endl
+       << bold << "--factored" << regular
+       << "            The MCTS agent expands each move as a direction, then" << endl
+       << "                      a removal (two levels of its tree)." << endl
+       << bold << "--checkpoint file" << regular
+       << "     Writes the tournament's progress to " << bold << "file" << regular << " every 100" << endl
+       << "                      games (--checkpoint-every n) and at the end.  The" << endl
+       << "                      games are the same as without it (same --seed)." << endl
+       << bold << "--resume file" << regular
+       << "         Continues the tournament checkpointed in " << bold << "file" << regular << ", with" << endl
+       << "                      the same agents, board, openings, --paired and --sprt." << endl
+       << bold << "--seed n" << regular
+       << "              Seeds the random number generator (default: time)." << endl
+       << bold << "--network file" << regular
+       << "        Search agents evaluate with the network in " << bold << "file" << regular << '.' << endl
+       << bold << "--weights file" << regular
+       << "        Search agents use the evaluation weights in " << bold << "file" << regular << " (see tune)." << endl
        << bold << "-o | --output" << regular
        << "         Outputs turn-by-turn moves." << endl
        << bold << "-p | --pause" << regular
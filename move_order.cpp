@@ -0,0 +1,96 @@
+/*
+ * File: move_order.cpp
+ * Author: Joshua T. Guerin
+ * Description: Implementation of move ordering.  See move_order.h.
+ */
+
+#include <algorithm>  // sort()
+#include <functional> // greater
+
+#include "move_order.h"
+
+using namespace std;
+
+// Sort keys: the score above the (inverted) position in the generator's
+// list, so that ties keep their order.  History scores stay below the
+// killers' and the table move's.
+static const uint32_t table_move_score = 0xffffffff;
+static const uint32_t killer_score = 0xfffffff0;
+static const uint32_t max_history = 0x7fffffff;
+
+
+move_order::move_order(unsigned n) : board_size(0) {
+  new_search(n);
+}
+
+
+void move_order::new_search(unsigned n) {
+  if(n != board_size) {
+    board_size = n;
+    history.assign(8 * n * n, 0);
+  }
+  else
+    age();
+
+  killer_count.clear();
+}
+
+
+void move_order::age() {
+  for(unsigned i=0; i<history.size(); i++)
+    history[i] /= 2;
+}
+
+
+void move_order::order(vector<action>& actions, unsigned ply,
+		       const action* table_move) {
+  unsigned count = actions.size();
+  keys.resize(count);
+
+  unsigned killers_known = ply < killer_count.size() ? killer_count[ply] : 0;
+  for(unsigned i=0; i<count; i++) {
+    const action& a = actions[i];
+    uint32_t score = history[history_index(a)];
+
+    if(table_move != 0 && same(a, *table_move))
+      score = table_move_score;
+    else
+      for(unsigned k=0; k<killers_known; k++)
+	if(same(a, killers[ply * num_killers + k])) {
+	  score = killer_score - k;
+	  break;
+	}
+
+    keys[i] = (uint64_t(score) << 32) | (0xffffffff - i);
+  }
+
+  sort(keys.begin(), keys.end(), greater<uint64_t>());
+
+  sorted.resize(count);
+  for(unsigned i=0; i<count; i++)
+    sorted[i] = actions[0xffffffff - (keys[i] & 0xffffffff)];
+  actions.swap(sorted);
+}
+
+
+void move_order::cutoff(const action& a, unsigned ply, unsigned depth) {
+  // Deep cutoffs save the most work, so they count the most.
+  uint32_t& score = history[history_index(a)];
+  score += depth * depth;
+  if(score > max_history)
+    age();
+
+  // The newest killer first; an action is never its ply's killer twice.
+  if(ply >= killer_count.size()) {
+    killer_count.resize(ply + 1, 0);
+    killers.resize((ply + 1) * num_killers);
+  }
+  action* slots = &killers[ply * num_killers];
+  if(killer_count[ply] > 0 && same(slots[0], a))
+    return;
+  for(unsigned k=num_killers-1; k>0; k--)
+    slots[k] = slots[k-1];
+  slots[0] = a;
+  if(killer_count[ply] < num_killers)
+    killer_count[ply]++;
+}
@@ -0,0 +1,88 @@
+/*
+ * File: move_order.h
+ * Author: Joshua T. Guerin
+ * Purpose: Move ordering for search agents.  Alpha-beta prunes most when
+ *          the best action at a node is searched first, and an isola node
+ *          has ~8n^2 (direction, removal) actions with nothing in the
+ *          action itself to rank them by, so the ranking is learned while
+ *          searching:
+ *              1. the transposition table's move (best at the position
+ *                 last time it was searched), if any,
+ *              2. the killer moves of the ply (the last two actions that
+ *                 caused a cutoff at the same distance from the root),
+ *              3. the rest by history score: how often, and how deep, the
+ *                 action (direction, removed square) caused a cutoff
+ *                 anywhere in the tree.
+ *          Ties keep the move generator's order (isola::legal_actions()).
+ *
+ * Use: Call order() on the actions of a node before searching them, and
+ *      cutoff() with the action that fails high.  new_search() between
+ *      searches keeps history (halved) and forgets the killers, whose
+ *      plies no longer line up.
+ */
+
+#ifndef MOVE_ORDER_H
+#define MOVE_ORDER_H
+
+#include <stdint.h> // uint32_t, uint64_t
+#include <vector>   // Tables, action lists
+
+#include "types.h" // Isola/tournament types.
+
+
+class move_order {
+  /*
+   * Description: History and killer tables for one searcher (not shared
+   *              between threads).
+   */
+ private:
+  static const unsigned num_killers = 2;
+
+  unsigned board_size;
+  std::vector<uint32_t> history;  // [direction * n*n + removed square]
+  std::vector<action> killers;    // num_killers per ply
+  std::vector<unsigned char> killer_count;
+
+  // Scratch space for order(), kept to avoid allocating per node.
+  std::vector<uint64_t> keys;
+  std::vector<action> sorted;
+
+  unsigned history_index(const action& a) {
+    return (unsigned(a.move_to) * board_size + a.remove.row) * board_size +
+      a.remove.col;
+  }
+
+  static bool same(const action& a, const action& b) {
+    return a.move_to == b.move_to && a.remove.row == b.remove.row &&
+      a.remove.col == b.remove.col;
+  }
+
+  void age();
+  /*
+   * Description: Halves every history score.
+   */
+
+ public:
+  move_order(unsigned n = 7);
+
+  void new_search(unsigned n);
+  /*
+   * Description: Prepares for a search of an nxn board: halves history
+   *              (clears it if n has changed) and clears the killers.
+   */
+
+  void order(std::vector<action>& actions, unsigned ply,
+	     const action* table_move);
+  /*
+   * Description: Sorts actions (all legal at a node ply plies from the
+   *              root) best first, as above.  table_move may be 0.
+   */
+
+  void cutoff(const action& a, unsigned ply, unsigned depth);
+  /*
+   * Description: Records that a failed high ply plies from the root, with
+   *              depth plies left to search.
+   */
+};
+
+#endif
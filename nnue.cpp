@@ -0,0 +1,285 @@
+/*
+ * File: nnue.cpp
+ * Author: Joshua T. Guerin
+ * Description: Implementation of the quantized network evaluation.  See
+ *              nnue.h for the network layout.
+ */
+
+#include <cstdio>  // FILE
+#include <cstring> // memcmp()
+#include <random>  // randomize()
+
+#ifdef __AVX2__
+#include <immintrin.h> // AVX2 intrinsics
+#endif
+
+#include "nnue.h"
+
+using namespace std;
+
+static const char nnue_magic[8] = {'I','S','O','L','A','N','N','1'};
+
+
+template <typename T>
+static bool read_array(FILE* file, vector<T>& values, size_t count) {
+  values.resize(count);
+  return fread(&values[0], sizeof(T), count, file) == count;
+}
+
+template <typename T>
+static bool write_array(FILE* file, const vector<T>& values) {
+  return fwrite(&values[0], sizeof(T), values.size(), file) ==
+    values.size();
+}
+
+
+bool nnue_network::load(const string& filename) {
+  FILE* file = fopen(filename.c_str(), "rb");
+  char magic[8];
+  uint32_t header[3];
+
+  if(file == NULL)
+    return false;
+
+  // Note: Weights are stored in the machine's byte order, which is
+  // little-endian on every platform we build for.
+  bool ok = fread(magic, 1, 8, file) == 8 &&
+    memcmp(magic, nnue_magic, 8) == 0 &&
+    fread(header, sizeof(uint32_t), 3, file) == 3 &&
+    header[0] == NNUE_VERSION && header[1] >= 2 && header[1] <= 255 &&
+    header[2] % 32 == 0 && header[2] > 0 && header[2] <= max_hidden;
+
+  if(ok) {
+    board_size = header[1];
+    hidden_size = header[2];
+    unsigned features = 3 * board_size * board_size;
+
+    // The arrays must fill the rest of the file exactly, so a corrupt
+    // header is rejected before anything is allocated for it.
+    long start = ftell(file);
+    long bytes = sizeof(int16_t) * (features + 1) * hidden_size +
+      sizeof(int8_t) * layer2_size * 2 * hidden_size +
+      sizeof(int32_t) * layer2_size + sizeof(int8_t) * layer2_size +
+      sizeof(int32_t);
+
+    ok = start >= 0 && fseek(file, 0, SEEK_END) == 0 &&
+      ftell(file) - start == bytes && fseek(file, start, SEEK_SET) == 0 &&
+      read_array(file, feature_weights, features * hidden_size) &&
+      read_array(file, feature_bias, hidden_size) &&
+      read_array(file, layer2_weights, layer2_size * 2 * hidden_size) &&
+      read_array(file, layer2_bias, layer2_size) &&
+      read_array(file, output_weights, layer2_size) &&
+      fread(&output_bias, sizeof(int32_t), 1, file) == 1;
+  }
+
+  fclose(file);
+  return ok;
+}
+
+
+bool nnue_network::save(const string& filename) const {
+  FILE* file = fopen(filename.c_str(), "wb");
+  uint32_t header[3] = {NNUE_VERSION, board_size, hidden_size};
+
+  if(file == NULL)
+    return false;
+
+  bool ok = fwrite(nnue_magic, 1, 8, file) == 8 &&
+    fwrite(header, sizeof(uint32_t), 3, file) == 3 &&
+    write_array(file, feature_weights) &&
+    write_array(file, feature_bias) &&
+    write_array(file, layer2_weights) &&
+    write_array(file, layer2_bias) &&
+    write_array(file, output_weights) &&
+    fwrite(&output_bias, sizeof(int32_t), 1, file) == 1;
+
+  fclose(file);
+  return ok;
+}
+
+
+void nnue_network::randomize(unsigned n, unsigned hidden, unsigned seed) {
+  mt19937 rng(seed);
+  uniform_int_distribution<int> small(-16, 16), tiny(-4, 4);
+
+  board_size = n;
+  hidden_size = hidden;
+
+  feature_weights.resize(3 * n * n * hidden);
+  for(unsigned i=0; i<feature_weights.size(); i++)
+    feature_weights[i] = small(rng);
+  feature_bias.assign(hidden, 32);
+
+  layer2_weights.resize(layer2_size * 2 * hidden);
+  for(unsigned i=0; i<layer2_weights.size(); i++)
+    layer2_weights[i] = tiny(rng);
+  layer2_bias.assign(layer2_size, 0);
+
+  output_weights.resize(layer2_size);
+  for(unsigned i=0; i<layer2_size; i++)
+    output_weights[i] = small(rng);
+  output_bias = 0;
+}
+
+
+unsigned nnue_network::feature(player perspective, unsigned kind,
+			       location square) const {
+  unsigned row = (perspective == black) ? square.row
+    : board_size - 1 - square.row;
+  return kind * board_size * board_size + row * board_size + square.col;
+}
+
+
+void nnue_accumulator::add_feature(unsigned perspective, unsigned index) {
+  int16_t* out = &values[perspective][0];
+  const int16_t* weights = &network->feature_weights[index *
+						     network->hidden_size];
+  unsigned i = 0;
+
+#ifdef __AVX2__
+  for(; i + 16 <= network->hidden_size; i += 16) {
+    __m256i a = _mm256_loadu_si256((const __m256i*)(out + i));
+    __m256i w = _mm256_loadu_si256((const __m256i*)(weights + i));
+    _mm256_storeu_si256((__m256i*)(out + i), _mm256_add_epi16(a, w));
+  }
+#endif
+  for(; i < network->hidden_size; i++)
+    out[i] += weights[i];
+}
+
+
+void nnue_accumulator::sub_feature(unsigned perspective, unsigned index) {
+  int16_t* out = &values[perspective][0];
+  const int16_t* weights = &network->feature_weights[index *
+						     network->hidden_size];
+  unsigned i = 0;
+
+#ifdef __AVX2__
+  for(; i + 16 <= network->hidden_size; i += 16) {
+    __m256i a = _mm256_loadu_si256((const __m256i*)(out + i));
+    __m256i w = _mm256_loadu_si256((const __m256i*)(weights + i));
+    _mm256_storeu_si256((__m256i*)(out + i), _mm256_sub_epi16(a, w));
+  }
+#endif
+  for(; i < network->hidden_size; i++)
+    out[i] -= weights[i];
+}
+
+
+void nnue_accumulator::refresh(const nnue_network& net, isola& board) {
+  network = &net;
+
+  for(unsigned p=0; p<2; p++) {
+    player perspective = (p == 0) ? black : white;
+    values[p] = net.feature_bias;
+
+    for(unsigned i=0; i<net.board_size; i++)
+      for(unsigned j=0; j<net.board_size; j++)
+	if(board[i][j] == 'X')
+	  add_feature(p, net.feature(perspective, 0, location(i, j)));
+
+    add_feature(p, net.feature(perspective, perspective == black ? 1 : 2,
+			       board.find_player(black)));
+    add_feature(p, net.feature(perspective, perspective == white ? 1 : 2,
+			       board.find_player(white)));
+  }
+}
+
+
+void nnue_accumulator::move(isola& board, player p, const action& a) {
+  move_pawn(p, board.find_player(p), board.new_location(p, a.move_to));
+  remove_tile(a.remove);
+}
+
+
+void nnue_accumulator::undo(isola& board, player p, const action& a) {
+  restore_tile(a.remove);
+  move_pawn(p, board.new_location(p, a.move_to), board.find_player(p));
+}
+
+
+void nnue_accumulator::move_pawn(player p, location from, location to) {
+  for(unsigned q=0; q<2; q++) {
+    player perspective = (q == 0) ? black : white;
+    unsigned kind = (perspective == p) ? 1 : 2;
+    sub_feature(q, network->feature(perspective, kind, from));
+    add_feature(q, network->feature(perspective, kind, to));
+  }
+}
+
+
+void nnue_accumulator::remove_tile(location square) {
+  add_feature(0, network->feature(black, 0, square));
+  add_feature(1, network->feature(white, 0, square));
+}
+
+
+void nnue_accumulator::restore_tile(location square) {
+  sub_feature(0, network->feature(black, 0, square));
+  sub_feature(1, network->feature(white, 0, square));
+}
+
+
+static int32_t dot_product(const uint8_t* input, const int8_t* weights,
+			   unsigned size) {
+  /*
+   * Description: Sum of input[i]*weights[i].  size is a multiple of 64.
+   *
+   * Note: Inputs are at most 127, so the paired 16 bit products of
+   *       maddubs (at most 2*127*128) never saturate and the AVX2 and
+   *       scalar versions agree exactly.
+   */
+#ifdef __AVX2__
+  __m256i sum = _mm256_setzero_si256();
+  const __m256i ones = _mm256_set1_epi16(1);
+
+  for(unsigned i=0; i<size; i+=32) {
+    __m256i in = _mm256_loadu_si256((const __m256i*)(input + i));
+    __m256i w = _mm256_loadu_si256((const __m256i*)(weights + i));
+    __m256i pairs = _mm256_maddubs_epi16(in, w);
+    sum = _mm256_add_epi32(sum, _mm256_madd_epi16(pairs, ones));
+  }
+
+  __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum),
+			       _mm256_extracti128_si256(sum, 1));
+  half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4e));
+  half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xb1));
+  return _mm_cvtsi128_si32(half);
+#else
+  int32_t sum = 0;
+  for(unsigned i=0; i<size; i++)
+    sum += int32_t(input[i]) * weights[i];
+  return sum;
+#endif
+}
+
+
+static inline uint8_t clamp_activation(int32_t value) {
+  return value < 0 ? 0 : (value > 127 ? 127 : value);
+}
+
+
+int nnue_accumulator::evaluate(player to_move) const {
+  unsigned hidden = network->hidden_size;
+  unsigned own = (to_move == black) ? 0 : 1;
+  uint8_t input[2 * nnue_network::max_hidden];
+  uint8_t layer2[nnue_network::layer2_size];
+
+  for(unsigned i=0; i<hidden; i++) {
+    input[i] = clamp_activation(values[own][i]);
+    input[hidden + i] = clamp_activation(values[1 - own][i]);
+  }
+
+  for(unsigned j=0; j<nnue_network::layer2_size; j++) {
+    int32_t sum = network->layer2_bias[j] +
+      dot_product(input, &network->layer2_weights[j * 2 * hidden],
+		  2 * hidden);
+    layer2[j] = clamp_activation(sum >> nnue_network::layer2_shift);
+  }
+
+  int32_t output = network->output_bias;
+  for(unsigned j=0; j<nnue_network::layer2_size; j++)
+    output += int32_t(layer2[j]) * network->output_weights[j];
+
+  return output / nnue_network::output_scale;
+}
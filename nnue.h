@@ -0,0 +1,136 @@
+/*
+ * File: nnue.h
+ * Author: Joshua T. Guerin
+ * Purpose: A small quantized neural-network evaluation function for isola
+ *          whose first layer is updated incrementally as moves are made
+ *          (an "NNUE"-style accumulator).
+ *
+ * Network: For each perspective (black, white) the inputs are 3*n*n
+ *          binary features: removed square, own pawn square, opponent pawn
+ *          square.  White's perspective mirrors the rows, so both players
+ *          see their own pawn starting at the top.
+ *              layer 1: 3*n*n -> hidden        int16, kept in accumulators
+ *              layer 2: 2*hidden -> 32         int8 weights, int32 sums
+ *              layer 3: 32 -> 1                int8 weights, int32 sum
+ *          The side to move's accumulator comes first in layer 2's input.
+ *          Activations are clamped to [0, 127].
+ *
+ * Notes: Dense layers use AVX2 when compiled with it (e.g.,
+ *        make ARCH_FLAGS=-mavx2) and plain loops otherwise; both give
+ *        identical results.
+ */
+
+#ifndef NNUE_H
+#define NNUE_H
+
+#include <stdint.h> // Fixed-width weights
+#include <string>   // File names
+#include <vector>   // Weights
+
+#include "isola.h" // Game logic
+#include "types.h" // Isola/tournament types.
+
+#define NNUE_VERSION 1
+
+
+class nnue_network {
+  /*
+   * Description: Quantized weights, loaded from (or saved to) a file.
+   *
+   * File format (little-endian): "ISOLANN1", version (u32), board size
+   *     (u32), hidden size (u32), then the arrays in the order declared
+   *     below.
+   */
+ public:
+  static const unsigned layer2_size = 32;
+  static const unsigned max_hidden = 1024;
+
+  // Scales: layer 2 sums are shifted right by layer2_shift before
+  // clamping; the output is divided by output_scale.
+  static const int layer2_shift = 6;
+  static const int output_scale = 16;
+
+  unsigned board_size, hidden_size;
+
+  std::vector<int16_t> feature_weights; // [3*n*n][hidden]
+  std::vector<int16_t> feature_bias;    // [hidden]
+  std::vector<int8_t>  layer2_weights;  // [32][2*hidden]
+  std::vector<int32_t> layer2_bias;     // [32]
+  std::vector<int8_t>  output_weights;  // [32]
+  int32_t output_bias;
+
+  nnue_network() : board_size(0), hidden_size(0), output_bias(0) {}
+
+  bool load(const std::string& filename);
+  /*
+   * Returns:
+   *     false - the file is missing or not a valid network: another
+   *             version, a board size outside 2 ... 255, a hidden size
+   *             that is not a multiple of 32 up to max_hidden, or a file
+   *             length other than the one the sizes imply.
+   */
+
+  bool save(const std::string& filename) const;
+
+  void randomize(unsigned n, unsigned hidden, unsigned seed);
+  /*
+   * Description: Fills an n x n network with small random weights (for
+   *              benchmarking and testing; hidden must be a multiple of
+   *              32).
+   */
+
+  unsigned feature(player perspective, unsigned kind, location square) const;
+  /*
+   * Description: Index of a feature (kind 0: removed, 1: own pawn,
+   *              2: opponent pawn) as seen from perspective.
+   */
+};
+
+
+class nnue_accumulator {
+  /*
+   * Description: Layer 1 outputs for both perspectives of one position.
+   *              Updated incrementally with move(), or rebuilt with
+   *              refresh().
+   */
+ private:
+  const nnue_network* network;
+  std::vector<int16_t> values[2]; // [black, white][hidden]
+
+  void add_feature(unsigned perspective, unsigned index);
+  void sub_feature(unsigned perspective, unsigned index);
+
+ public:
+  nnue_accumulator() : network(0) {}
+
+  void refresh(const nnue_network& net, isola& board);
+  /*
+   * Description: Recomputes both perspectives from scratch.
+   */
+
+  void move(isola& board, player p, const action& a);
+  /*
+   * Description: Applies a's changes (pawn step, then tile removal),
+   *              given the board _before_ a is played.  Touches only the
+   *              three affected features per perspective.
+   */
+
+  void undo(isola& board, player p, const action& a);
+  /*
+   * Description: Reverses move(board, p, a), for make/unmake search.
+   */
+
+  void move_pawn(player p, location from, location to);
+  void remove_tile(location square);
+  void restore_tile(location square);
+
+  int evaluate(player to_move) const;
+  /*
+   * Description: Runs layers 2 and 3.
+   *
+   * Returns:
+   *     The value of the position for to_move (positive is good).
+   */
+};
+
+#endif
@@ -0,0 +1,356 @@
+/*
+ * File: perft.cpp
+ * Author: Joshua T. Guerin
+ * Purpose: Move generation correctness and speed.  Counts the leaf
+ *          positions (move sequences) to each depth from a position with
+ *          the fast generator (isola::legal_actions()), optionally checks
+ *          the counts against a brute-force enumeration of every
+ *          direction and square with legal_move(p, d, location), and
+ *          reports leaves/second.
+ *
+ * Notes: perft(0) is 1; a position whose game is over (either pawn
+ *        stuck) has no leaves below it.  The last ply is counted without
+ *        being generated (mobility x open squares: each legal direction
+ *        allows every open square but the destination, plus the square
+ *        being vacated) unless --no-bulk is given.
+ */
+
+
+#include <iostream>  // console io
+#include <chrono>    // Timing
+#include <ctime>     // time() for the default seed
+#include <getopt.h>  // getopt()
+#include <cstdlib>   // atoi()
+#include <algorithm> // remove()
+#include <atomic>    // Parallel leaf counts
+#include <random>    // Random openings
+#include <vector>    // Root actions
+
+#include "isola.h"       // Game logic
+#include "thread_pool.h" // Root moves in parallel
+#include "types.h"       // Types associated with game/tournament.
+
+using namespace std;
+
+// Perft Flags
+unsigned max_depth=3;
+unsigned grid_size=7;
+unsigned num_threads=1;
+unsigned opening_plies=0;
+unsigned seed=time(NULL);
+player first_move=black;
+bool check_counts=false;
+bool divide=false;
+bool bulk_counting=true;
+string start_position; // Text form (isola::to_text()), if given
+
+
+void parse_args(int argc, char *argv[]);
+/*
+ * Description: Parses command line arguments, sets associated flags.
+ */
+
+
+void help(string binary_name, string options);
+/*
+ * Description: Prints usage message if -h or --help flags arguments
+ *              are passed on the command line.
+ */
+
+
+unsigned long long perft(isola& board, player to_move, unsigned depth);
+/*
+ * Description: Leaves depth plies below board with the fast generator.
+ */
+
+
+unsigned long long brute_perft(isola& board, player to_move,
+			       unsigned depth);
+/*
+ * Description: Leaves depth plies below board, trying every direction and
+ *              square with legal_move() and checking for the end of the
+ *              game without the cached mobility.
+ */
+
+
+unsigned long long root_perft(isola& board, player to_move, unsigned depth,
+			      thread_pool& pool, bool print_divide);
+/*
+ * Description: perft() with the root actions shared between the pool's
+ *              threads.  If print_divide is set, prints each root action's
+ *              count.
+ */
+
+
+int main(int argc, char *argv[]) {
+  parse_args(argc, argv);
+
+  // The starting position: the opening is random but seeded.
+  isola board(grid_size);
+  player to_move = first_move;
+  if(!start_position.empty()) {
+    if(!isola::from_text(start_position, board, to_move)) {
+      cerr << "Error: Not a valid position: " << start_position << endl;
+      return 1;
+    }
+    grid_size = board.max_rows();
+  }
+  mt19937 rng(seed);
+  for(unsigned ply=0; ply<opening_plies && board.game_result() == playing;
+      ply++) {
+    action next = board.random_action(to_move, rng);
+    board.move(to_move, next.move_to, next.remove);
+    to_move = (to_move == white) ? black : white;
+  }
+
+  cout << bold << "Position:" << regular << ' ' << grid_size << 'x'
+       << grid_size << ", " << (to_move == white ? "white" : "black")
+       << " to move";
+  if(opening_plies > 0)
+    cout << " (" << opening_plies << " random plies, seed " << seed << ")";
+  cout << endl;
+  board.print();
+  cout << endl;
+
+  thread_pool pool(num_threads ? num_threads :
+		   thread_pool::default_threads());
+  unsigned mismatches = 0;
+
+  for(unsigned depth=1; depth<=max_depth; depth++) {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    unsigned long long leaves = root_perft(board, to_move, depth, pool,
+					   divide && depth == max_depth);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() -
+					      start).count();
+
+    cout << bold << "perft(" << depth << "): " << regular << leaves
+	 << " (" << seconds << " s, " << leaves / seconds << " leaves/s)";
+
+    if(check_counts) {
+      start = chrono::steady_clock::now();
+      unsigned long long expected = brute_perft(board, to_move, depth);
+      double brute_seconds =
+	chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+      if(expected == leaves)
+	cout << ", brute force agrees (" << brute_seconds << " s)";
+      else {
+	cout << ", brute force: " << expected << " MISMATCH";
+	mismatches++;
+      }
+    }
+    cout << endl;
+  }
+
+  return mismatches == 0 ? 0 : 1;
+}
+
+
+unsigned long long perft(isola& board, player to_move, unsigned depth) {
+  if(depth == 0)
+    return 1;
+  if(board.game_result() != playing)
+    return 0;
+  if(depth == 1 && bulk_counting)
+    return (unsigned long long)board.mobility(to_move) * board.open_count();
+
+  player opponent = (to_move == black) ? white : black;
+  vector<action> actions = board.legal_actions(to_move);
+  unsigned long long leaves = 0;
+
+  for(unsigned i=0; i<actions.size(); i++) {
+    isola child = board;
+    child.move(to_move, actions[i].move_to, actions[i].remove);
+    leaves += perft(child, opponent, depth - 1);
+  }
+  return leaves;
+}
+
+
+unsigned long long brute_perft(isola& board, player to_move,
+			       unsigned depth) {
+  if(depth == 0)
+    return 1;
+
+  // The game is over once either pawn has no direction to move in.
+  for(unsigned p=0; p<2; p++) {
+    player pawn = p == 0 ? black : white;
+    bool stuck = true;
+    for(int d=north; d<=southeast && stuck; d++)
+      stuck = !board.legal_move(pawn, direction(d));
+    if(stuck)
+      return 0;
+  }
+
+  player opponent = (to_move == black) ? white : black;
+  unsigned n = board.max_rows();
+  unsigned long long leaves = 0;
+
+  for(int d=north; d<=southeast; d++)
+    for(unsigned row=0; row<n; row++)
+      for(unsigned col=0; col<n; col++) {
+	if(!board.legal_move(to_move, direction(d), location(row, col)))
+	  continue;
+
+	isola child = board;
+	child.move(to_move, direction(d), location(row, col));
+	leaves += brute_perft(child, opponent, depth - 1);
+      }
+  return leaves;
+}
+
+
+unsigned long long root_perft(isola& board, player to_move, unsigned depth,
+			      thread_pool& pool, bool print_divide) {
+  if(depth <= 1 || board.game_result() != playing)
+    return perft(board, to_move, depth);
+
+  player opponent = (to_move == black) ? white : black;
+  vector<action> actions = board.legal_actions(to_move);
+  vector<unsigned long long> counts(actions.size());
+
+  for(unsigned i=0; i<actions.size(); i++)
+    pool.submit([&board, &actions, &counts, to_move, opponent, depth, i]() {
+	isola child = board;
+	child.move(to_move, actions[i].move_to, actions[i].remove);
+	counts[i] = perft(child, opponent, depth - 1);
+      });
+  pool.wait();
+
+  unsigned long long leaves = 0;
+  for(unsigned i=0; i<actions.size(); i++) {
+    leaves += counts[i];
+    if(print_divide)
+      cout << "  direction " << actions[i].move_to << ", remove ("
+	   << actions[i].remove.row << ", " << actions[i].remove.col
+	   << "): " << counts[i] << endl;
+  }
+  return leaves;
+}
+
+
+void parse_args(int argc, char *argv[]) {
+  int option;
+  opterr = 0;
+
+  // getopt_long arguments
+  string options = "cd:g:hj:";
+  const struct option long_options[] =
+    {
+      {"check",       no_argument,        0, 'c'},
+      {"depth",       required_argument,  0, 'd'},
+      {"grid",        required_argument,  0, 'g'},
+      {"help",        no_argument,        0, 'h'},
+      {"threads",     required_argument,  0, 'j'},
+      {"divide",      no_argument,        0, 'V'},
+      {"no-bulk",     no_argument,        0, 'U'},
+      {"openings",    required_argument,  0, 'O'},
+      {"position",    required_argument,  0, 'P'},
+      {"seed",        required_argument,  0, 'D'},
+      {"white",       no_argument,        0, 'W'},
+      {0,0,0,0},
+    };
+  int option_index;
+
+  option = getopt_long(argc, argv, options.c_str(),
+		       long_options, &option_index);
+
+  while(option != -1) {
+    switch(option) {
+    case 'c':
+      // Brute-force cross-check
+      check_counts = true;
+      break;
+    case 'd':
+      // Deepest depth counted
+      max_depth = atoi(optarg);
+      break;
+    case 'g':
+      // Grid size flag
+      grid_size = atoi(optarg);
+      break;
+    case 'h':
+      // Help flag
+      help(argv[0], options);
+      exit(0);
+      break;
+    case 'j':
+      // Number of worker threads (0: all hardware threads)
+      num_threads = atoi(optarg);
+      break;
+    case 'V':
+      // Per root action counts (long option only)
+      divide = true;
+      break;
+    case 'U':
+      // Generate the last ply too (long option only)
+      bulk_counting = false;
+      break;
+    case 'O':
+      // Random opening length (long option only)
+      opening_plies = atoi(optarg);
+      break;
+    case 'P':
+      // Start position (long option only)
+      start_position = optarg;
+      break;
+    case 'D':
+      // Seed of the opening (long option only)
+      seed = strtoul(optarg, NULL, 10);
+      break;
+    case 'W':
+      // White moves first (long option only)
+      first_move = white;
+      break;
+    case '?':
+      cerr << "Error: Unrecognized argument or missing value." << endl
+	   << "See the -h option for usage." << endl;
+      exit(0);
+      break;
+    default:
+      cerr << "Error: Unknown argument: " << char(option) << endl;
+      exit(0);
+      break;
+    }
+
+    option = getopt_long(argc, argv, options.c_str(),
+			 long_options, &option_index);
+  }
+}
+
+
+void help(string binary_name, string options) {
+  options.erase(remove(options.begin(), options.end(), ':'), options.end());
+
+  cout << bold << "NAME\n\t" << binary_name << regular << " -- counts isola move sequences to check and time move generation" << endl
+       << bold << "SYNOPSIS: \n\t" << binary_name
+       << " [-" << options << "]" << regular << endl
+       << bold << "OPTIONS:" << regular << endl
+       << bold << "-c | --check" << regular
+       << "          Checks each count against a brute-force enumeration" << endl
+       << "                      with legal_move()." << endl
+       << bold << "-d | --depth n" << regular
+       << "        Counts to depths 1 ... " << bold << 'n' << regular << " (default: 3)." << endl
+       << bold << "-g | --grid n" << regular
+       << "         Sets gameboard size to " << bold << 'n' << regular << 'x' << bold << 'n' << regular << '.' << endl
+       << bold << "-h | --help" << regular
+       << "           Print this help." << endl
+       << bold << "-j | --threads n" << regular
+       << "      Shares root moves between " << bold << 'n' << regular << " threads (default: 1; 0: all" << endl
+       << "                      hardware threads)." << endl
+       << bold << "--divide" << regular
+       << "              Prints the count below each root move at the deepest" << endl
+       << "                      depth." << endl
+       << bold << "--no-bulk" << regular
+       << "             Generates and applies the last ply too, instead of" << endl
+       << "                      counting it." << endl
+       << bold << "--openings n" << regular
+       << "          Starts from " << bold << 'n' << regular << " random legal moves." << endl
+       << bold << "--position text" << regular
+       << "       Starts from " << bold << "text" << regular << " (see isola::to_text()) instead of" << endl
+       << "                      the start position." << endl
+       << bold << "--seed n" << regular
+       << "              Seeds the opening (default: time)." << endl
+       << bold << "--white" << regular
+       << "               White moves first (default: black)." << endl;
+}
@@ -0,0 +1,166 @@
+/*
+ * File: profile.cpp
+ * Author: Joshua T. Guerin
+ * Description: Implementation of the hot-path counters.  See profile.h.
+ */
+
+#include "profile.h"
+
+#ifdef ISOLA_PROFILE
+
+#include <atomic>    // Counters read by other threads
+#include <mutex>     // Thread list
+#include <vector>    // Thread list
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h> // __rdtsc()
+#define PROFILE_CYCLES 1
+#else
+#include <chrono>      // Fallback clock
+#endif
+
+using namespace std;
+
+static const char* const counter_names[num_profile_counters] = {
+  "isola::move",
+  "isola::legal_move(p,d)",
+  "isola::legal_move(p,d,remove)",
+  "isola::game_result",
+  "isola::new_location",
+  "isola::copy",
+  "agent::next_move"
+};
+
+
+struct thread_counters {
+  // Only the owning thread writes; relaxed loads and stores (plain moves
+  // on x86) let profile_report() read them while it runs.
+  atomic<uint64_t> calls[num_profile_counters];
+  atomic<uint64_t> cycles[num_profile_counters];
+
+  // The counts at the last profile_reset() (guarded by threads_lock).
+  uint64_t reset_calls[num_profile_counters];
+  uint64_t reset_cycles[num_profile_counters];
+
+  thread_counters();
+  ~thread_counters();
+};
+
+// Every live thread's counters, plus the sums of exited threads' (since
+// the last reset).
+static mutex threads_lock;
+static vector<thread_counters*> threads;
+static uint64_t exited_calls[num_profile_counters];
+static uint64_t exited_cycles[num_profile_counters];
+
+static thread_local thread_counters counters;
+
+// Start of the copy being timed on this thread (copies never nest).
+static thread_local uint64_t copy_start;
+
+
+thread_counters::thread_counters() {
+  for(unsigned i=0; i<num_profile_counters; i++) {
+    calls[i].store(0, memory_order_relaxed);
+    cycles[i].store(0, memory_order_relaxed);
+    reset_calls[i] = reset_cycles[i] = 0;
+  }
+
+  lock_guard<mutex> lock(threads_lock);
+  threads.push_back(this);
+}
+
+
+thread_counters::~thread_counters() {
+  lock_guard<mutex> lock(threads_lock);
+  for(unsigned i=0; i<num_profile_counters; i++) {
+    exited_calls[i] += calls[i].load(memory_order_relaxed) - reset_calls[i];
+    exited_cycles[i] += cycles[i].load(memory_order_relaxed) -
+      reset_cycles[i];
+  }
+  for(size_t i=0; i<threads.size(); i++)
+    if(threads[i] == this) {
+      threads[i] = threads.back();
+      threads.pop_back();
+      break;
+    }
+}
+
+
+uint64_t profile_clock() {
+#ifdef PROFILE_CYCLES
+  return __rdtsc();
+#else
+  return chrono::duration_cast<chrono::nanoseconds>(
+    chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+
+void profile_add(profile_counter counter, uint64_t cycles) {
+  atomic<uint64_t>& c = counters.calls[counter];
+  atomic<uint64_t>& t = counters.cycles[counter];
+  c.store(c.load(memory_order_relaxed) + 1, memory_order_relaxed);
+  t.store(t.load(memory_order_relaxed) + cycles, memory_order_relaxed);
+}
+
+
+void profile_reset() {
+  // Storing zeros into other threads' counters could be lost between
+  // their load and store, so only their current values are recorded.
+  lock_guard<mutex> lock(threads_lock);
+  for(unsigned i=0; i<num_profile_counters; i++) {
+    exited_calls[i] = exited_cycles[i] = 0;
+    for(size_t j=0; j<threads.size(); j++) {
+      threads[j]->reset_calls[i] =
+	threads[j]->calls[i].load(memory_order_relaxed);
+      threads[j]->reset_cycles[i] =
+	threads[j]->cycles[i].load(memory_order_relaxed);
+    }
+  }
+}
+
+
+void profile_report(ostream& out) {
+  lock_guard<mutex> lock(threads_lock);
+
+#ifdef PROFILE_CYCLES
+  out << "profile\tcounter\tcalls\tcycles\n";
+#else
+  out << "profile\tcounter\tcalls\tns\n";
+#endif
+  for(unsigned i=0; i<num_profile_counters; i++) {
+    uint64_t calls = exited_calls[i], cycles = exited_cycles[i];
+    for(size_t j=0; j<threads.size(); j++) {
+      calls += threads[j]->calls[i].load(memory_order_relaxed) -
+	threads[j]->reset_calls[i];
+      cycles += threads[j]->cycles[i].load(memory_order_relaxed) -
+	threads[j]->reset_cycles[i];
+    }
+    out << "profile\t" << counter_names[i] << '\t' << calls << '\t'
+	<< cycles << '\n';
+  }
+  out.flush();
+}
+
+
+profile_copy_begin::profile_copy_begin(const profile_copy_begin&) {
+  copy_start = profile_clock();
+}
+
+profile_copy_begin&
+profile_copy_begin::operator=(const profile_copy_begin&) {
+  copy_start = profile_clock();
+  return *this;
+}
+
+profile_copy_end::profile_copy_end(const profile_copy_end&) {
+  profile_add(profile_board_copy, profile_clock() - copy_start);
+}
+
+profile_copy_end& profile_copy_end::operator=(const profile_copy_end&) {
+  profile_add(profile_board_copy, profile_clock() - copy_start);
+  return *this;
+}
+
+#endif
@@ -0,0 +1,136 @@
+/*
+ * File: profile.h
+ * Author: Joshua T. Guerin
+ * Purpose: Optional hot-path counters: calls and cycles spent in the
+ *          core's most called functions (isola::move(), the legal_move()
+ *          overloads it calls, game_result(), new_location(), board
+ *          copies) and in
+ *          agents' next_move(), to see where a game's time goes without
+ *          an external profiler.
+ *
+ * Use: Compiled in only with ISOLA_PROFILE defined, e.g.,
+ *          make clean && make PROFILE_FLAGS=-DISOLA_PROFILE
+ *      Otherwise PROFILE_SCOPE() expands to nothing and the other
+ *      functions are empty inlines, so the core is unchanged.
+ *
+ *      PROFILE_SCOPE(counter) at the top of a function counts a call and
+ *      the cycles until the function returns (inclusive of the counted
+ *      functions it calls).  Each thread counts into its own counters
+ *      (no atomic read-modify-writes or shared cache lines); a thread's
+ *      counts are kept after it exits.  profile_report() sums every
+ *      thread's counters.
+ *
+ * Report format (one line per counter, tab-separated, after a header):
+ *     profile  counter  calls  cycles
+ *     e.g., "profile\tisola::move\t81920\t5914880"
+ *     Cycles are read with rdtsc on x86; elsewhere the column is
+ *     nanoseconds and the header says ns.
+ *
+ * Note: Agent plugins are compiled with their own copy of the core, and
+ *       their counts are not reported.
+ */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <ostream> // profile_report()
+
+
+enum profile_counter {
+  profile_move,
+  profile_legal_direction,   // legal_move(p, d)
+  profile_legal_action,      // legal_move(p, d, remove)
+  profile_game_result,
+  profile_new_location,
+  profile_board_copy,
+  profile_next_move,
+  num_profile_counters
+};
+
+
+#ifdef ISOLA_PROFILE
+
+#include <stdint.h> // uint64_t
+
+uint64_t profile_clock();
+/*
+ * Description: The cycle counter (rdtsc), or nanoseconds where there is
+ *              none.
+ */
+
+void profile_add(profile_counter counter, uint64_t cycles);
+/*
+ * Description: Counts one call of counter, taking cycles, on this
+ *              thread's counters.
+ */
+
+void profile_reset();
+/*
+ * Description: Starts every thread's counts again from zero.  Counters
+ *              are only written by their own thread: the reset records
+ *              their current values, which later reports subtract.
+ */
+
+void profile_report(std::ostream& out);
+/*
+ * Description: Writes the counters, summed over every thread, to out
+ *              (see the report format above).
+ */
+
+
+class profile_scope {
+  /*
+   * Description: Counts from construction to destruction.
+   */
+ private:
+  profile_counter counter;
+  uint64_t start;
+
+ public:
+  explicit profile_scope(profile_counter c)
+    : counter(c), start(profile_clock()) {}
+  ~profile_scope() { profile_add(counter, profile_clock() - start); }
+
+  profile_scope(const profile_scope&) = delete;
+  profile_scope& operator=(const profile_scope&) = delete;
+};
+
+
+// Member pairs that time a class's implicit copies (profile_board_copy):
+// the begin member is declared before the class's data and the end member
+// after, so their copies (which the compiler makes in declaration order)
+// bracket it.  Moves are not counted.
+class profile_copy_begin {
+ public:
+  profile_copy_begin() {}
+  profile_copy_begin(const profile_copy_begin&);
+  profile_copy_begin(profile_copy_begin&&) {}
+  profile_copy_begin& operator=(const profile_copy_begin&);
+  profile_copy_begin& operator=(profile_copy_begin&&) { return *this; }
+};
+
+class profile_copy_end {
+ public:
+  profile_copy_end() {}
+  profile_copy_end(const profile_copy_end&);
+  profile_copy_end(profile_copy_end&&) {}
+  profile_copy_end& operator=(const profile_copy_end&);
+  profile_copy_end& operator=(profile_copy_end&&) { return *this; }
+};
+
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(counter) \
+  profile_scope PROFILE_CONCAT(profile_scope_, __LINE__)(counter)
+
+#else
+
+inline void profile_reset() {}
+inline void profile_report(std::ostream&) {}
+
+#define PROFILE_SCOPE(counter)
+
+#endif
+
+#endif
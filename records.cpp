@@ -0,0 +1,172 @@
+/*
+ * File: records.cpp
+ * Author: Joshua T. Guerin
+ * Description: Implementation of position records.  See records.h for
+ *              the file format.
+ */
+
+#include <cstring> // memcmp()
+
+#include "records.h"
+
+using namespace std;
+
+static const char records_magic[8] = {'I','S','O','L','A','P','O','S'};
+
+
+static void put_u16(unsigned char* out, unsigned value) {
+  out[0] = value & 0xff;
+  out[1] = (value >> 8) & 0xff;
+}
+
+static void put_u32(unsigned char* out, unsigned value) {
+  put_u16(out, value & 0xffff);
+  put_u16(out + 2, value >> 16);
+}
+
+static unsigned get_u16(const unsigned char* in) {
+  return in[0] | (in[1] << 8);
+}
+
+static unsigned get_u32(const unsigned char* in) {
+  return get_u16(in) | (get_u16(in + 2) << 16);
+}
+
+
+position_record::position_record(isola& board, player side,
+				 int search_score) {
+  unsigned n = board.max_rows();
+  location b = board.find_player(black), w = board.find_player(white);
+
+  board_size = n;
+  black_square = b.row*n + b.col;
+  white_square = w.row*n + w.col;
+  to_move = side;
+  result = 0;
+
+  // Clamp the score into the record's 16 bits.
+  score = search_score > 32767 ? 32767 :
+    (search_score < -32767 ? -32767 : search_score);
+
+  removed.assign((n*n + 7) / 8, 0);
+  for(unsigned i=0; i<n; i++)
+    for(unsigned j=0; j<n; j++)
+      if(board[i][j] == 'X')
+	removed[(i*n + j) / 8] |= 1 << ((i*n + j) % 8);
+}
+
+
+isola position_record::unpack() const {
+  vector<vector<char> > cells(board_size, vector<char>(board_size, ' '));
+
+  for(unsigned square=0; square<board_size*board_size; square++)
+    if(is_removed(square))
+      cells[square / board_size][square % board_size] = 'X';
+
+  cells[black_square / board_size][black_square % board_size] = black;
+  cells[white_square / board_size][white_square % board_size] = white;
+  return isola(cells);
+}
+
+
+record_writer::record_writer(const string& filename, unsigned n)
+  : board_size(n), buffer(position_record::record_bytes(n)), failed(false) {
+  unsigned char header[20];
+
+  file = fopen(filename.c_str(), "wb");
+  if(file == NULL) {
+    failed = true;
+    return;
+  }
+
+  memcpy(header, records_magic, 8);
+  put_u32(header + 8, RECORDS_VERSION);
+  put_u32(header + 12, n);
+  put_u32(header + 16, buffer.size());
+  if(fwrite(header, 1, sizeof(header), file) != sizeof(header))
+    failed = true;
+}
+
+
+record_writer::~record_writer() {
+  close();
+}
+
+
+bool record_writer::close() {
+  if(file != NULL) {
+    if(fclose(file) != 0)
+      failed = true;
+    file = NULL;
+  }
+  return good();
+}
+
+
+void record_writer::write(const position_record& record) {
+  put_u16(&buffer[0], record.black_square);
+  put_u16(&buffer[2], record.white_square);
+  buffer[4] = (record.to_move == black) ? 0 : 1;
+  buffer[5] = (unsigned char)(signed char) record.result;
+  put_u16(&buffer[6], (unsigned)(record.score & 0xffff));
+  memcpy(&buffer[8], &record.removed[0], record.removed.size());
+
+  if(file == NULL ||
+     fwrite(&buffer[0], 1, buffer.size(), file) != buffer.size())
+    failed = true;
+}
+
+
+record_reader::record_reader(const string& filename)
+  : board_size(0), record_size(0) {
+  unsigned char header[20];
+
+  file = fopen(filename.c_str(), "rb");
+  if(file == NULL)
+    return;
+
+  if(fread(header, 1, sizeof(header), file) != sizeof(header) ||
+     memcmp(header, records_magic, 8) != 0 ||
+     get_u32(header + 8) != RECORDS_VERSION) {
+    fclose(file);
+    file = NULL;
+    return;
+  }
+
+  // Squares are u16s, and the record size must be the one the board size
+  // implies (a larger one would make next() read past the bitmap).
+  board_size = get_u32(header + 12);
+  record_size = get_u32(header + 16);
+  if(board_size < 2 || board_size > 255 ||
+     record_size != position_record::record_bytes(board_size)) {
+    fclose(file);
+    file = NULL;
+    return;
+  }
+  buffer.resize(record_size);
+}
+
+
+record_reader::~record_reader() {
+  if(file != NULL)
+    fclose(file);
+}
+
+
+bool record_reader::next(position_record& record) {
+  if(fread(&buffer[0], 1, record_size, file) != record_size)
+    return false;
+
+  record.board_size = board_size;
+  record.black_square = get_u16(&buffer[0]);
+  record.white_square = get_u16(&buffer[2]);
+  record.to_move = buffer[4] ? white : black;
+  record.result = (signed char) buffer[5];
+  record.score = (short) get_u16(&buffer[6]);
+  record.removed.assign(buffer.begin() + 8, buffer.end());
+
+  // unpack() indexes the board with the squares.
+  unsigned squares = board_size * board_size;
+  return record.black_square < squares && record.white_square < squares &&
+    record.black_square != record.white_square;
+}
@@ -0,0 +1,141 @@
+/*
+ * File: records.h
+ * Author: Joshua T. Guerin
+ * Purpose: Fixed-width binary records of labelled isola positions, as
+ *          written by the self-play generator and read back for training
+ *          or tuning evaluation functions.
+ *
+ * File format (all integers little-endian):
+ *     header: "ISOLAPOS" (8 bytes), version (u32), board size n (u32),
+ *             record size (u32)
+ *     records, each of record size = 8 + ceil(n*n/8) bytes:
+ *         black square (u16), white square (u16)   square = row*n + col
+ *         side to move (u8: 0 black, 1 white)
+ *         final result for the side to move (i8: 1 win, 0 tie, -1 loss)
+ *         search score for the side to move (i16)
+ *         removed squares (bitmap, bit square%8 of byte square/8)
+ */
+
+#ifndef RECORDS_H
+#define RECORDS_H
+
+#include <cstdio>  // FILE
+#include <string>  // File names
+#include <vector>  // Bitmaps, buffers
+
+#include "isola.h" // Game logic
+#include "types.h" // Isola/tournament types.
+
+#define RECORDS_VERSION 1
+
+
+struct position_record {
+  /*
+   * One labelled position.  See the file format above.
+   */
+  unsigned board_size;
+  unsigned black_square, white_square;
+  player to_move;
+  int result;
+  int score;
+  std::vector<unsigned char> removed;
+
+  position_record() : board_size(0), black_square(0), white_square(0),
+		      to_move(black), result(0), score(0) {}
+
+  position_record(isola& board, player side, int search_score);
+  /*
+   * Description: Packs board with side to move and its search score.
+   *              The result is filled in once the game is over.
+   */
+
+  isola unpack() const;
+  /*
+   * Description: Rebuilds the isola board described by the record.
+   */
+
+  bool is_removed(unsigned square) const {
+    return (removed[square / 8] >> (square % 8)) & 1;
+  }
+
+  static unsigned record_bytes(unsigned n) { return 8 + (n*n + 7) / 8; }
+};
+
+
+class record_writer {
+  /*
+   * Description: Appends position records to a file.
+   */
+ private:
+  FILE* file;
+  unsigned board_size;
+  std::vector<unsigned char> buffer;
+  bool failed;
+
+ public:
+  record_writer(const std::string& filename, unsigned n);
+  /*
+   * Description: Creates filename and writes the header for n x n boards.
+   *              Check is_open() afterwards.
+   */
+
+  ~record_writer();
+  /*
+   * Description: Closes the file if close() has not (unchecked).
+   */
+
+  bool is_open() const { return file != NULL; }
+
+  bool good() const { return !failed; }
+  /*
+   * Description: Whether the file was created and every write so far
+   *              succeeded.
+   */
+
+  void write(const position_record& record);
+
+  bool close();
+  /*
+   * Description: Flushes and closes the file.
+   *
+   * Returns:
+   *     good() after the file is closed: false if any write (including
+   *     the final flush) failed.
+   */
+};
+
+
+class record_reader {
+  /*
+   * Description: Reads position records back from a file.
+   */
+ private:
+  FILE* file;
+  unsigned board_size, record_size;
+  std::vector<unsigned char> buffer;
+
+ public:
+  record_reader(const std::string& filename);
+  /*
+   * Description: Opens filename and reads its header.  Check is_open()
+   *              afterwards (false also if the header is not valid: a
+   *              board size outside 2 ... 255, or a record size other than
+   *              position_record::record_bytes() of it).
+   */
+
+  ~record_reader();
+
+  bool is_open() const { return file != NULL; }
+
+  unsigned size() const { return board_size; }
+
+  bool next(position_record& record);
+  /*
+   * Returns:
+   *     true  - record holds the next position.
+   *     false - there are no more (complete) records, or the next one
+   *             has a pawn off the board.
+   */
+};
+
+#endif
@@ -0,0 +1,236 @@
+/*
+ * File: registry.cpp
+ * Author: Joshua T. Guerin
+ * Description: Implementation of the runtime agent registry and
+ *              runtime_agent.  See registry.h for details.
+ */
+
+#include <cctype>   // tolower()
+#include <chrono>   // Call timing
+#include <iomanip>  // setw(), setprecision()
+#include <iostream> // Console io
+
+#include <dirent.h> // opendir(), readdir()
+#include <dlfcn.h>  // dlopen(), dlsym()
+
+#include "registry.h"
+
+using namespace std;
+
+agent_entry* runtime_agent::selected[2] = {0, 0};
+
+
+agent_registry::~agent_registry() {
+  for(unsigned i=0; i<libraries.size(); i++)
+    dlclose(libraries[i]);
+}
+
+
+bool agent_registry::add(const isola_agent_plugin* plugin,
+			 const string& path) {
+  if(plugin->abi_version != ISOLA_AGENT_ABI_VERSION)
+    return false;
+
+  agent_entry entry;
+  entry.plugin = plugin;
+  entry.name = plugin->name();
+  entry.path = path;
+  entry.key = make_key(entry.name);
+
+  // Agents are keyed by name, and the first agent with a key keeps it: a
+  // plugin built from a built-in agent has its own copy of the agent's
+  // static settings (e.g., mcts_agent::agent::set_factored()), which the
+  // driver never sets.
+  for(unsigned i=0; i<entries.size(); i++)
+    if(entries[i].key == entry.key)
+      return false;
+
+  entries.push_back(entry);
+  return true;
+}
+
+
+unsigned agent_registry::load_directory(const string& directory) {
+  unsigned loaded = 0;
+  DIR* dir = opendir(directory.c_str());
+
+  if(dir == NULL)
+    return 0;
+
+  for(dirent* file = readdir(dir); file != NULL; file = readdir(dir)) {
+    string filename = file->d_name;
+    if(filename.size() <= 3 ||
+       filename.compare(filename.size() - 3, 3, ".so") != 0)
+      continue;
+
+    string path = directory + "/" + filename;
+    void* library = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if(library == NULL) {
+      cerr << "Warning: Could not load " << path << ": " << dlerror() << endl;
+      continue;
+    }
+
+    isola_agent_entry entry =
+      (isola_agent_entry) dlsym(library, ISOLA_AGENT_ENTRY);
+    if(entry == NULL) {
+      cerr << "Warning: " << path << " does not export "
+	   << ISOLA_AGENT_ENTRY << "()." << endl;
+      dlclose(library);
+      continue;
+    }
+
+    const isola_agent_plugin* plugin = entry();
+    if(plugin->abi_version != ISOLA_AGENT_ABI_VERSION) {
+      cerr << "Warning: " << path << " was built for agent ABI version "
+	   << plugin->abi_version << " (expected "
+	   << ISOLA_AGENT_ABI_VERSION << ")." << endl;
+      dlclose(library);
+      continue;
+    }
+
+    if(!add(plugin, path)) {
+      cerr << "Warning: " << path << " is ignored: agent "
+	   << make_key(plugin->name()) << " is already registered." << endl;
+      dlclose(library);
+      continue;
+    }
+
+    libraries.push_back(library);
+    loaded++;
+  }
+
+  closedir(dir);
+  return loaded;
+}
+
+
+agent_entry* agent_registry::find(const string& name) {
+  string key = make_key(name);
+
+  for(unsigned i=0; i<entries.size(); i++)
+    if(entries[i].key == key)
+      return &entries[i];
+
+  return 0;
+}
+
+
+void agent_registry::list() {
+  cout << bold << "Available agents:" << regular << endl;
+  for(unsigned i=0; i<entries.size(); i++) {
+    cout << "  " << left << setw(20) << entries[i].key << right
+	 << entries[i].name;
+    if(!entries[i].path.empty())
+      cout << " (" << entries[i].path << ")";
+    cout << endl;
+  }
+}
+
+
+void agent_registry::print_call_stats() {
+  cout << bold << "Agent call overhead:" << regular << endl;
+
+  for(unsigned i=0; i<entries.size(); i++) {
+    const agent_entry& e = entries[i];
+    if(e.calls == 0)
+      continue;
+
+    double overhead = double(e.marshal_ns + e.adapter_ns) / e.calls;
+    double total = double(e.call_ns) / e.calls;
+
+    cout << "  " << left << setw(20) << e.key << right
+	 << e.calls << " calls, " << fixed << setprecision(1)
+	 << total/1000 << " us/call, interface overhead "
+	 << overhead << " ns/call ("
+	 << setprecision(2) << (total > 0 ? 100*overhead/total : 0) << "%)"
+	 << defaultfloat << endl;
+  }
+}
+
+
+string agent_registry::make_key(const string& name) {
+  string key = name;
+
+  for(unsigned i=0; i<key.size(); i++) {
+    if(key[i] == ' ' || key[i] == '-')
+      key[i] = '_';
+    else
+      key[i] = tolower(key[i]);
+  }
+  return key;
+}
+
+
+runtime_agent::runtime_agent(player c, agent_entry* e) : color(c), entry(e) {
+  instance = entry->plugin->create(c, agent_seed());
+}
+
+
+runtime_agent::~runtime_agent() {
+  entry->adapter_ns += entry->plugin->overhead_ns(instance);
+  entry->plugin->destroy(instance);
+}
+
+
+action runtime_agent::next_move(isola current_board) {
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+  // Flatten the board for the C interface.
+  unsigned size = current_board.max_rows();
+  cells.resize(size*size);
+  for(unsigned i=0; i<size; i++)
+    for(unsigned j=0; j<size; j++)
+      cells[i*size + j] = current_board[i][j];
+
+  isola_board_view view;
+  view.size = size;
+  view.cells = cells.data();
+
+  chrono::steady_clock::time_point call = chrono::steady_clock::now();
+  isola_move next = entry->plugin->next_move(instance, &view);
+  chrono::steady_clock::time_point end = chrono::steady_clock::now();
+
+  entry->calls++;
+  entry->marshal_ns += chrono::duration_cast<chrono::nanoseconds>
+    (call - start).count();
+  entry->call_ns += chrono::duration_cast<chrono::nanoseconds>
+    (end - start).count();
+
+  return action(direction(next.move_to),
+		location(next.remove_row, next.remove_col));
+}
+
+
+void runtime_agent::opponent_moved(const action& a) {
+  isola_move move;
+  move.move_to = a.move_to;
+  move.remove_row = a.remove.row;
+  move.remove_col = a.remove.col;
+  entry->plugin->opponent_moved(instance, &move);
+}
+
+
+void runtime_agent::ponder(isola board, const ponder_signal& signal) {
+  // Runs alongside next_move() of the other agent, so it has its own
+  // buffer rather than sharing cells.
+  unsigned size = board.max_rows();
+  vector<char> flat(size*size);
+  for(unsigned i=0; i<size; i++)
+    for(unsigned j=0; j<size; j++)
+      flat[i*size + j] = board[i][j];
+
+  isola_board_view view;
+  view.size = size;
+  view.cells = flat.data();
+  entry->plugin->ponder(instance, &view, &signal);
+}
+
+
+void runtime_agent::select(unsigned slot, agent_entry* e) {
+  selected[slot] = e;
+}
+
+
+string runtime_agent::selected_name(unsigned slot) {
+  return selected[slot]->name;
+}
@@ -0,0 +1,189 @@
+/*
+ * File: registry.h
+ * Author: Joshua T. Guerin
+ * Purpose: Runtime agent selection.  The registry holds every agent that
+ *          can be chosen by name on the command line: the built-in agents
+ *          (agents/agents.h) and any agent shared objects loaded from a
+ *          plugin directory.  runtime_agent wraps a registry entry in the
+ *          usual agent contract so it can be used with tournament.
+ */
+
+#ifndef REGISTRY_H
+#define REGISTRY_H
+
+#include <deque>  // Entries (stable addresses)
+#include <string> // Agent names/keys
+#include <vector> // Board buffer, library handles
+
+#include "agent_abi.h" // Stable agent interface
+#include "isola.h"     // Game logic
+#include "types.h"     // Isola/tournament types.
+
+
+struct agent_entry {
+  /*
+   * One selectable agent.
+   *   - key is the name used on the command line (e.g., random_agent).
+   *   - path is the shared object it came from (empty for built-ins).
+   */
+  std::string key, name, path;
+  const isola_agent_plugin* plugin;
+
+  // Call statistics gathered by runtime_agent.
+  unsigned long long calls, call_ns, marshal_ns, adapter_ns;
+
+  agent_entry() : plugin(0), calls(0), call_ns(0), marshal_ns(0),
+		  adapter_ns(0) {}
+};
+
+
+class agent_registry {
+  /*
+   * Description: Stores selectable agents, looked up by key.
+   */
+ private:
+  std::deque<agent_entry> entries;
+  std::vector<void*> libraries;
+
+  template <typename TAgent>
+  void add_builtins(agent_list<TAgent>) {
+    add(plugin_adapter<TAgent>::table(), "");
+  }
+
+  template <typename TAgent, typename TNext, typename... TRest>
+  void add_builtins(agent_list<TAgent, TNext, TRest...>) {
+    add(plugin_adapter<TAgent>::table(), "");
+    add_builtins(agent_list<TNext, TRest...>());
+  }
+
+ public:
+  ~agent_registry();
+  /*
+   * Description: Closes all loaded shared objects.
+   */
+
+  template <typename... TAgents>
+  void add(agent_list<TAgents...> agents) { add_builtins(agents); }
+  /*
+   * Description: Registers every agent in a compile-time agent list.
+   */
+
+  bool add(const isola_agent_plugin* plugin, const std::string& path);
+  /*
+   * Description: Registers one agent function table.  An agent whose key
+   *              is already registered (e.g., a plugin built from a
+   *              built-in agent) is not added: the first one is kept.
+   *
+   * Returns:
+   *     false - the plugin was built for a different ABI version, or its
+   *             key is taken.
+   */
+
+  unsigned load_directory(const std::string& directory);
+  /*
+   * Description: dlopen()s every .so file in directory and registers the
+   *              agents they export.  Problems are reported on cerr.
+   *
+   * Returns:
+   *     The number of agents loaded.
+   */
+
+  agent_entry* find(const std::string& name);
+  /*
+   * Description: Looks an agent up by key or display name (ignoring
+   *              case, spaces and dashes).  Returns 0 if not found.
+   */
+
+  void list();
+  /*
+   * Description: Prints every registered agent.
+   */
+
+  void print_call_stats();
+  /*
+   * Description: Prints how much time runtime agents spent on interface
+   *              overhead compared with the agents' own next_move().
+   */
+
+  static std::string make_key(const std::string& name);
+  /*
+   * Description: Normalizes a name into a key: lowercase, with spaces and
+   *              dashes turned into underscores.
+   */
+};
+
+
+class runtime_agent {
+  /*
+   * Description: An agent whose implementation is a registry entry chosen
+   *              at runtime.  See selected_agent for use with tournament.
+   */
+ private:
+  player color;
+  agent_entry* entry;
+  void* instance;
+  std::vector<char> cells; // Flattened board passed across the interface
+
+  runtime_agent(const runtime_agent&);
+  runtime_agent& operator=(const runtime_agent&);
+
+ protected:
+  static agent_entry* selected[2];
+
+ public:
+  runtime_agent(player c, agent_entry* e);
+  ~runtime_agent();
+  action next_move(isola current_board);
+  std::string name() { return entry->name; }
+
+  void opponent_moved(const action& a);
+  /*
+   * Description: Forwards the opponent's move to the agent (which may
+   *              ignore it).
+   */
+
+  bool can_ponder() const { return entry->plugin->ponder != 0; }
+  /*
+   * Description: Whether the agent has a ponder() hook (see ponderer).
+   */
+
+  void ponder(isola board, const ponder_signal& signal);
+  /*
+   * Description: Lets the agent think on the opponent's time (it may
+   *              return at once).  Called on a background thread, only if
+   *              can_ponder().
+   */
+
+  static void select(unsigned slot, agent_entry* e);
+  /*
+   * Description: Chooses the agent used by every selected_agent<slot>
+   *              constructed afterwards.
+   */
+
+  static std::string selected_name(unsigned slot);
+  /*
+   * Description: The name of the agent chosen for slot.
+   */
+};
+
+
+template <unsigned slot>
+class selected_agent : public runtime_agent {
+  /*
+   * Description: Follows the usual agent contract (agent(player)) for the
+   *              agent chosen with runtime_agent::select(slot, ...).  E.g.,
+   *                  tournament<selected_agent<0>, selected_agent<1> >
+   *              Slots (rather than colors) identify the agents, so agents
+   *              can switch colors between games.
+   */
+ public:
+  selected_agent(player c) : runtime_agent(c, selected[slot]) {}
+};
+
+
+template <unsigned slot>
+struct agent_name_of<selected_agent<slot>, false> {
+  static std::string name() { return runtime_agent::selected_name(slot); }
+};
+
+#endif
@@ -0,0 +1,45 @@
+/*
+ * File: seeds.h
+ * Author: Joshua T. Guerin
+ * Purpose: Seeds for agents' random number generators.  An agent that
+ *          makes random choices seeds its generator with agent_seed() when
+ *          it is constructed; tournament::run_simulation(seed) calls
+ *          seed_agents() before constructing a game's agents, so a seeded
+ *          game replays exactly.
+ *
+ * Notes: Each thread has its own seeds, so games played on several threads
+ *        at once (league.h) neither race on shared state (as rand() would)
+ *        nor depend on the order in which the threads run.
+ */
+
+#ifndef SEEDS_H
+#define SEEDS_H
+
+#include <random> // mt19937
+
+
+inline std::mt19937& agent_seeds() {
+  /*
+   * Description: This thread's seed generator.
+   */
+  static thread_local std::mt19937 seeds;
+  return seeds;
+}
+
+
+inline void seed_agents(unsigned seed) {
+  /*
+   * Description: Restarts this thread's agent seeds from seed.
+   */
+  agent_seeds().seed(seed);
+}
+
+
+inline unsigned agent_seed() {
+  /*
+   * Description: The next seed for an agent constructed on this thread.
+   */
+  return agent_seeds()();
+}
+
+#endif
@@ -0,0 +1,649 @@
+/*
+ * File: selfcheck.cpp
+ * Author: Joshua T. Guerin
+ * Purpose: Self-checks of the core, run by make check.  Each check plays
+ *          seeded random games and, at every position, compares a fast
+ *          routine with a slow reference (or checks a property that must
+ *          hold), then prints one line.  Exits with 1 if any check fails.
+ *
+ * Notes: The default seed is fixed, so a run is repeatable; --seed tries
+ *        other games.
+ */
+
+
+#include <iostream>  // console io
+#include <getopt.h>  // getopt()
+#include <cstdlib>   // atoi(), strtoul()
+#include <algorithm> // remove(), min()
+#include <cmath>     // sqrt(), pow()
+#include <random>    // Random games
+#include <string>    // Positions in failure messages
+#include <unordered_map> // Minimax values
+#include <vector>    // Action lists
+
+#include "isola.h"    // Game logic
+#include "nnue.h"     // Saturated networks
+#include "solver.h"   // Proof-number solver
+#include "symmetry.h" // Board symmetries, position hashes
+#include "types.h"    // Types associated with game/tournament.
+#include "agents/alphabeta_agent.h" // Network scores in search
+
+using namespace std;
+
+// Check Flags
+unsigned num_games=300;
+unsigned seed=1;
+
+
+void parse_args(int argc, char *argv[]);
+/*
+ * Description: Parses command line arguments, sets associated flags.
+ */
+
+
+void help(string binary_name, string options);
+/*
+ * Description: Prints usage message if -h or --help flags arguments
+ *              are passed on the command line.
+ */
+
+
+template <typename TCheck>
+unsigned random_games(unsigned n, unsigned games, unsigned max_plies,
+		      mt19937& rng, TCheck check);
+/*
+ * Description: Plays games random games on an n x n board (up to
+ *              max_plies plies each, random first mover) and calls
+ *              check(board, to_move) at every position, the last one
+ *              included, until it returns false.
+ *
+ * Returns:
+ *     The number of positions checked.
+ */
+
+
+bool report(const string& check, bool passed, const string& details);
+/*
+ * Description: Prints check's result line and returns passed.
+ */
+
+
+bool check_legal_actions(mt19937& rng);
+/*
+ * Description: isola::legal_actions() (open-square lists) against every
+ *              direction and square tried with legal_move(p, d, remove),
+ *              in the same order, on 3x3 to 64x64 boards.
+ */
+
+
+bool check_random_action(mt19937& rng);
+/*
+ * Description: isola::random_action() draws only legal actions, each as
+ *              often as the others: a chi-square test of the counts
+ *              (summed over every position sampled) against uniform.
+ */
+
+
+bool check_symmetries(mt19937& rng);
+/*
+ * Description: Under each of the 8 symmetries (symmetry.h), on 3x3 to
+ *              11x11 boards: legal actions transform to the transformed
+ *              board's legal actions, a successor transforms to the
+ *              transformed board's successor, every transform has the
+ *              same canonical hash (and symmetric_hashes() are their
+ *              position hashes), and inverses round-trip.
+ */
+
+
+bool check_encodings(mt19937& rng);
+/*
+ * Description: isola::to_text() and to_binary() read back (from_text(),
+ *              from_binary()) as the same position, with the same legal
+ *              actions, on 2x2 to 16x16 boards; truncated binary and
+ *              malformed text are rejected.
+ */
+
+
+bool check_solver(mt19937& rng);
+/*
+ * Description: pn_solver's values (win, tie or loss) and best moves at
+ *              positions of random 3x3 and 4x4 games (10 open squares or
+ *              fewer), on one and on three threads, against a memoised
+ *              minimax.
+ */
+
+
+bool check_network_clamp(mt19937& rng);
+/*
+ * Description: The alpha-beta agent's scores stay within +/-max_eval
+ *              (clear of win scores) when it evaluates with a network
+ *              whose weights are all at their limits, so that its
+ *              outputs are far outside that range.
+ */
+
+
+int main(int argc, char *argv[]) {
+  parse_args(argc, argv);
+
+  mt19937 rng(seed);
+  bool passed = true;
+
+  passed = check_legal_actions(rng) && passed;
+  passed = check_random_action(rng) && passed;
+  passed = check_symmetries(rng) && passed;
+  passed = check_encodings(rng) && passed;
+  passed = check_solver(rng) && passed;
+  passed = check_network_clamp(rng) && passed;
+
+  return passed ? 0 : 1;
+}
+
+
+template <typename TCheck>
+unsigned random_games(unsigned n, unsigned games, unsigned max_plies,
+		      mt19937& rng, TCheck check) {
+  unsigned positions = 0;
+
+  for(unsigned game=0; game<games; game++) {
+    isola board(n);
+    player to_move = (rng() % 2 == 0) ? black : white;
+
+    for(unsigned ply=0; ; ply++) {
+      positions++;
+      if(!check(board, to_move))
+	return positions;
+      if(ply == max_plies || board.game_result() != playing)
+	break;
+
+      vector<action> actions = board.legal_actions(to_move);
+      const action& next = actions[uniform_int_distribution<size_t>(
+	0, actions.size() - 1)(rng)];
+      board.move(to_move, next.move_to, next.remove);
+      to_move = (to_move == white) ? black : white;
+    }
+  }
+  return positions;
+}
+
+
+bool report(const string& check, bool passed, const string& details) {
+  cout << bold << check << ": " << regular << (passed ? "ok" : "FAILED")
+       << " (" << details << ")" << endl;
+  return passed;
+}
+
+
+bool check_legal_actions(mt19937& rng) {
+  const unsigned sizes[] = { 3, 4, 5, 7, 9, 16, 64 };
+  unsigned positions = 0;
+  string failed;
+
+  for(unsigned i=0; i<sizeof(sizes)/sizeof(sizes[0]) && failed.empty();
+      i++) {
+    unsigned n = sizes[i];
+
+    // Large boards' games are long and each position tries 8*n*n actions,
+    // so fewer, shorter games are checked there.
+    unsigned games = n <= 9 ? num_games : (num_games + 29) / 30;
+    unsigned max_plies = n <= 9 ? n*n : 200;
+
+    positions += random_games(n, games, max_plies, rng,
+			      [&failed, n](isola& board, player to_move) {
+	vector<action> expected;
+	for(int d=north; d<=southeast; d++)
+	  for(unsigned row=0; row<n; row++)
+	    for(unsigned col=0; col<n; col++)
+	      if(board.legal_move(to_move, direction(d), location(row, col)))
+		expected.push_back(action(direction(d), location(row, col)));
+
+	vector<action> actions = board.legal_actions(to_move);
+	bool same = actions.size() == expected.size();
+	for(size_t k=0; same && k<actions.size(); k++)
+	  same = actions[k].move_to == expected[k].move_to &&
+	    actions[k].remove.row == expected[k].remove.row &&
+	    actions[k].remove.col == expected[k].remove.col;
+
+	if(!same)
+	  failed = board.to_text(to_move);
+	return same;
+      });
+  }
+
+  return report("legal_actions", failed.empty(),
+		failed.empty() ?
+		to_string(positions) + " positions match brute force" :
+		"differs from brute force at " + failed);
+}
+
+
+bool check_random_action(mt19937& rng) {
+  const unsigned sizes[] = { 3, 5, 7 };
+  double chi_square = 0;
+  unsigned long long degrees = 0, draws = 0;
+  string failed;
+
+  for(unsigned i=0; i<sizeof(sizes)/sizeof(sizes[0]) && failed.empty();
+      i++) {
+    unsigned n = sizes[i];
+    random_games(n, num_games, n*n, rng,
+		 [&](isola& board, player to_move) {
+	// A sample of the positions (a few per game), while the game goes on.
+	if(board.game_result() != playing || rng() % 8 != 0)
+	  return true;
+
+	// Actions by direction and square, about 20 draws expected for each.
+	vector<action> actions = board.legal_actions(to_move);
+	vector<int> index(8*n*n, -1);
+	for(size_t k=0; k<actions.size(); k++)
+	  index[actions[k].move_to*n*n + actions[k].remove.row*n +
+		actions[k].remove.col] = k;
+
+	unsigned samples = 20 * actions.size();
+	vector<unsigned> counts(actions.size());
+	for(unsigned s=0; s<samples; s++) {
+	  action a = board.random_action(to_move, rng);
+	  int k = (a.remove.row < n && a.remove.col < n) ?
+	    index[a.move_to*n*n + a.remove.row*n + a.remove.col] : -1;
+	  if(k < 0) {
+	    failed = "illegal action drawn at " + board.to_text(to_move);
+	    return false;
+	  }
+	  counts[k]++;
+	}
+
+	double expected = double(samples) / actions.size();
+	for(size_t k=0; k<counts.size(); k++)
+	  chi_square += (counts[k] - expected) * (counts[k] - expected) /
+	    expected;
+	degrees += actions.size() - 1;
+	draws += samples;
+	return true;
+      });
+  }
+
+  // The statistic's 1 - 1e-6 quantile (Wilson-Hilferty: z = 4.75).
+  double k = degrees, h = 2 / (9 * k);
+  double limit = k * pow(1 - h + 4.75 * sqrt(h), 3);
+  if(failed.empty() && chi_square > limit)
+    failed = "chi-square " + to_string(chi_square) + " with " +
+      to_string(degrees) + " degrees of freedom, above " + to_string(limit);
+
+  return report("random_action", failed.empty(),
+		failed.empty() ?
+		to_string(draws) + " draws, chi-square " +
+		to_string(chi_square / degrees) + " per degree of freedom" :
+		failed);
+}
+
+
+static vector<unsigned> action_keys(const vector<action>& actions,
+				    unsigned n) {
+  // Sorted, so that lists in different orders compare equal.
+  vector<unsigned> keys(actions.size());
+  for(size_t k=0; k<actions.size(); k++)
+    keys[k] = actions[k].move_to*n*n + actions[k].remove.row*n +
+      actions[k].remove.col;
+  sort(keys.begin(), keys.end());
+  return keys;
+}
+
+
+static bool same_board(isola& a, isola& b) {
+  return a.current_board() == b.current_board();
+}
+
+
+bool check_symmetries(mt19937& rng) {
+  unsigned positions = 0;
+  string failed;
+
+  for(unsigned n=3; n<=11 && failed.empty(); n++)
+    positions += random_games(n, (num_games + 8) / 9, n*n, rng,
+			      [&](isola& board, player to_move) {
+	player opponent = (to_move == black) ? white : black;
+	vector<action> actions = board.legal_actions(to_move);
+	bool playing_on = board.game_result() == playing;
+	action played = playing_on ? actions[rng() % actions.size()] :
+	  action();
+	isola child = board;
+	if(playing_on)
+	  child.move(to_move, played.move_to, played.remove);
+
+	uint64_t hashes[num_symmetries];
+	symmetric_hashes(board, to_move, hashes);
+	uint64_t canonical = canonicalize(board, to_move).hash;
+	string problem;
+
+	for(unsigned s=0; s<num_symmetries && problem.empty(); s++) {
+	  isola image = transform_board(board, s);
+
+	  vector<action> mapped(actions.size());
+	  for(size_t k=0; k<actions.size(); k++)
+	    mapped[k] = transform_action(actions[k], s, n);
+	  if(action_keys(mapped, n) !=
+	     action_keys(image.legal_actions(to_move), n))
+	    problem = "legal actions";
+
+	  if(playing_on) {
+	    isola image_child = image;
+	    action a = transform_action(played, s, n);
+	    image_child.move(to_move, a.move_to, a.remove);
+	    isola child_image = transform_board(child, s);
+	    if(!same_board(image_child, child_image))
+	      problem = "successor";
+	    else if(position_hash(image_child, opponent) !=
+		    update_position_hash(position_hash(image, to_move), n,
+					 to_move, image.find_player(to_move),
+					 image_child.find_player(to_move),
+					 a.remove))
+	      problem = "updated hash";
+	  }
+
+	  if(hashes[s] != position_hash(image, to_move))
+	    problem = "symmetric hash";
+	  if(canonicalize(image, to_move).hash != canonical)
+	    problem = "canonical hash";
+
+	  unsigned inverse = inverse_symmetry(s);
+	  isola back = transform_board(image, inverse);
+	  if(!same_board(back, board))
+	    problem = "inverse board";
+	  for(unsigned square=0; square<n*n && problem.empty(); square++) {
+	    location l(square / n, square % n);
+	    location there = transform_location(l, s, n);
+	    location home = transform_location(there, inverse, n);
+	    if(home.row != l.row || home.col != l.col)
+	      problem = "inverse square";
+	  }
+	  for(int d=north; d<=southeast && problem.empty(); d++)
+	    if(transform_direction(transform_direction(direction(d), s),
+				   inverse) != d)
+	      problem = "inverse direction";
+
+	  if(!problem.empty())
+	    failed = problem + " under symmetry " + to_string(s) + " at " +
+	      board.to_text(to_move);
+	}
+	return problem.empty();
+      });
+
+  return report("symmetries", failed.empty(),
+		failed.empty() ?
+		to_string(positions) + " positions, 8 symmetries each" :
+		failed);
+}
+
+
+bool check_encodings(mt19937& rng) {
+  const unsigned sizes[] = { 2, 3, 5, 7, 8, 9, 16 };
+  unsigned positions = 0;
+  string failed;
+
+  for(unsigned i=0; i<sizeof(sizes)/sizeof(sizes[0]) && failed.empty();
+      i++) {
+    unsigned n = sizes[i];
+    positions += random_games(n, (num_games + 6) / 7, n*n, rng,
+			      [&](isola& board, player to_move) {
+	string text = board.to_text(to_move);
+	vector<unsigned char> data;
+	board.to_binary(to_move, data);
+	vector<unsigned> actions = action_keys(board.legal_actions(to_move), n);
+
+	isola from_text(2), from_binary(2);
+	player text_to_move, binary_to_move;
+	string problem;
+	if(!isola::from_text(text, from_text, text_to_move))
+	  problem = "text rejected";
+	else if(!same_board(from_text, board) || text_to_move != to_move ||
+		action_keys(from_text.legal_actions(to_move), n) != actions)
+	  problem = "text differs";
+	else if(data.size() != isola::binary_size(n) ||
+		isola::from_binary(data.data(), data.size(), from_binary,
+				   binary_to_move) != data.size())
+	  problem = "binary rejected";
+	else if(!same_board(from_binary, board) ||
+		binary_to_move != to_move ||
+		action_keys(from_binary.legal_actions(to_move), n) != actions)
+	  problem = "binary differs";
+	else if(isola::from_binary(data.data(), data.size() - 1, from_binary,
+				   binary_to_move) != 0)
+	  problem = "truncated binary accepted";
+
+	if(!problem.empty())
+	  failed = problem + " at " + text;
+	return problem.empty();
+      });
+  }
+
+  // Runs that overflow, rows of unequal length, a missing pawn, a bad
+  // side to move.
+  const char* const malformed[] = {
+    "4294967297b1/3/1w1 b", "1b1/4/1w1 b", "1b1/3/3 b", "1b1/3/1w1 x", ""
+  };
+  for(unsigned i=0; i<sizeof(malformed)/sizeof(malformed[0]) &&
+	failed.empty(); i++) {
+    isola board(2);
+    player to_move;
+    if(isola::from_text(malformed[i], board, to_move))
+      failed = "accepted \"" + string(malformed[i]) + "\"";
+  }
+
+  return report("encodings", failed.empty(),
+		failed.empty() ?
+		to_string(positions) + " positions read back from text and "
+		"binary" : failed);
+}
+
+
+static int minimax(isola& board, player to_move,
+		   unordered_map<uint64_t, int>& values) {
+  // 1 win, 0 tie, -1 loss for to_move, as in solution::value.
+  switch(board.game_result()) {
+  case tied:
+    return 0;
+  case black_won:
+    return to_move == black ? 1 : -1;
+  case white_won:
+    return to_move == white ? 1 : -1;
+  case playing:
+    break;
+  }
+
+  uint64_t hash = position_hash(board, to_move);
+  unordered_map<uint64_t, int>::const_iterator known = values.find(hash);
+  if(known != values.end())
+    return known->second;
+
+  player opponent = (to_move == black) ? white : black;
+  vector<action> actions = board.legal_actions(to_move);
+  int best = -1;
+  for(size_t k=0; k<actions.size() && best < 1; k++) {
+    isola child = board;
+    child.move(to_move, actions[k].move_to, actions[k].remove);
+    best = max(best, -minimax(child, opponent, values));
+  }
+  values[hash] = best;
+  return best;
+}
+
+
+bool check_solver(mt19937& rng) {
+  unordered_map<uint64_t, int> values;
+  unsigned positions = 0;
+  string failed;
+
+  for(unsigned n=3; n<=4 && failed.empty(); n++) {
+    // Fresh tables for each size, shared by its positions.
+    pn_solver one_thread(16), three_threads(16);
+    three_threads.set_threads(3);
+    pn_solver* solvers[2] = { &one_thread, &three_threads };
+
+    random_games(n, (num_games + 1) / 2, n*n, rng,
+		 [&](isola& board, player to_move) {
+	// Minimax from the early 4x4 positions visits millions of positions.
+	if(rng() % 4 != 0 || board.open_count() > 10)
+	  return true;
+	positions++;
+
+	player opponent = (to_move == black) ? white : black;
+	int expected = minimax(board, to_move, values);
+	for(unsigned t=0; t<2 && failed.empty(); t++) {
+	  solution result = solvers[t]->solve(board, to_move);
+	  string threads = t == 0 ? " (one thread)" : " (three threads)";
+
+	  if(!result.solved || result.value != expected)
+	    failed = "value " + to_string(result.value) + ", minimax " +
+	      to_string(expected) + threads;
+	  else if(result.value >= 0 && board.game_result() == playing) {
+	    // The best move must be legal and keep the value.
+	    isola child = board;
+	    if(!result.has_best ||
+	       !board.legal_move(to_move, result.best.move_to,
+				 result.best.remove))
+	      failed = "no legal best move" + threads;
+	    else {
+	      child.move(to_move, result.best.move_to, result.best.remove);
+	      if(-minimax(child, opponent, values) != expected)
+		failed = "best move does not keep the value" + threads;
+	    }
+	  }
+	}
+
+	if(!failed.empty())
+	  failed += " at " + board.to_text(to_move);
+	return failed.empty();
+      });
+  }
+
+  return report("solver", failed.empty(),
+		failed.empty() ?
+		to_string(positions) + " positions agree with minimax" :
+		failed);
+}
+
+
+bool check_network_clamp(mt19937& rng) {
+  typedef alphabeta_agent::agent agent;
+  const unsigned n = 5;
+  unsigned positions = 0, clamped = 0;
+  string failed;
+
+  // Every accumulator and layer 2 activation saturates at 127, so the
+  // output is 32*127*127/16 (about 32000) times the sign of the output
+  // weights.
+  for(int sign=-1; sign<=1 && failed.empty(); sign+=2) {
+    nnue_network network;
+    network.randomize(n, 32, rng());
+    fill(network.feature_weights.begin(), network.feature_weights.end(), 127);
+    fill(network.feature_bias.begin(), network.feature_bias.end(), 127);
+    fill(network.layer2_weights.begin(), network.layer2_weights.end(), 127);
+    fill(network.layer2_bias.begin(), network.layer2_bias.end(), 0);
+    fill(network.output_weights.begin(), network.output_weights.end(),
+	 sign * 127);
+    network.output_bias = 0;
+
+    agent::set_network(&network);
+    for(unsigned depth=1; depth<=2 && failed.empty(); depth++) {
+      agent::set_depth(depth);
+      positions += random_games(n, (num_games + 29) / 30, n*n, rng,
+				[&](isola& board, player to_move) {
+	  if(board.game_result() != playing)
+	    return true;
+
+	  // Wins and losses found within the depth score beyond max_eval,
+	  // but never more than win_score.
+	  agent searcher(to_move);
+	  searcher.next_move(board);
+	  int score = abs(searcher.score());
+	  bool within = score <= agent::max_eval ||
+	    (score >= agent::win_score - int(depth) &&
+	     score <= agent::win_score);
+	  clamped += score == agent::max_eval;
+	  if(!within)
+	    failed = "score " + to_string(score) + " at depth " +
+	      to_string(depth) + " at " + board.to_text(to_move);
+	  return within;
+	});
+    }
+  }
+  agent::set_network(0);
+  agent::set_depth(2);
+
+  // Most scores come from saturated evaluations.
+  if(failed.empty() && clamped < positions / 2)
+    failed = "only " + to_string(clamped) + " of " + to_string(positions) +
+      " scores at max_eval";
+
+  return report("network clamp", failed.empty(),
+		failed.empty() ?
+		to_string(positions) + " searches with saturated networks, " +
+		to_string(clamped) + " at max_eval" :
+		failed);
+}
+
+
+void parse_args(int argc, char *argv[]) {
+  int option;
+  opterr = 0;
+
+  // getopt_long arguments
+  string options = "hn:";
+  const struct option long_options[] =
+    {
+      {"help",        no_argument,        0, 'h'},
+      {"games",       required_argument,  0, 'n'},
+      {"seed",        required_argument,  0, 'D'},
+      {0,0,0,0},
+    };
+  int option_index;
+
+  option = getopt_long(argc, argv, options.c_str(),
+		       long_options, &option_index);
+
+  while(option != -1) {
+    switch(option) {
+    case 'h':
+      // Help flag
+      help(argv[0], options);
+      exit(0);
+      break;
+    case 'n':
+      // Random games per check
+      num_games = atoi(optarg);
+      break;
+    case 'D':
+      // Seed of the games (long option only)
+      seed = strtoul(optarg, NULL, 10);
+      break;
+    case '?':
+      cerr << "Error: Unrecognized argument or missing value." << endl
+	   << "See the -h option for usage." << endl;
+      exit(0);
+      break;
+    default:
+      cerr << "Error: Unknown argument: " << char(option) << endl;
+      exit(0);
+      break;
+    }
+
+    option = getopt_long(argc, argv, options.c_str(),
+			 long_options, &option_index);
+  }
+}
+
+
+void help(string binary_name, string options) {
+  options.erase(remove(options.begin(), options.end(), ':'), options.end());
+
+  cout << bold << "NAME\n\t" << binary_name << regular << " -- checks the game logic against slow references on random games" << endl
+       << bold << "SYNOPSIS: \n\t" << binary_name
+       << " [-" << options << "]" << regular << endl
+       << bold << "OPTIONS:" << regular << endl
+       << bold << "-h | --help" << regular
+       << "           Print this help." << endl
+       << bold << "-n | --games n" << regular
+       << "        Plays " << bold << 'n' << regular << " random games per board size and check" << endl
+       << "                      (default: 300)." << endl
+       << bold << "--seed n" << regular
+       << "              Seeds the games (default: 1)." << endl;
+}
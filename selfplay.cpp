@@ -0,0 +1,215 @@
+/*
+ * File: selfplay.cpp
+ * Author: Joshua T. Guerin
+ * Purpose: Driver for self-play data generation.
+ *          Manages command line arguments and runs the generator.
+ *
+ */
+
+
+#include <iostream>  // console io
+#include <ctime>     // time() for the default seed
+#include <getopt.h>  // getopt()
+#include <cstdlib>   // atoi(), atof()
+#include <algorithm> // remove()
+
+#include "selfplay.h"     // Templated class that generates positions.
+#include "thread_pool.h"  // default_threads()
+#include "types.h"        // Types associated with game/tournament.
+
+#include "nnue.h"         // Optional network evaluation
+#include "agents/alphabeta_agent.h" // The search agent playing itself.
+
+using namespace std;
+
+// Generation Flags
+unsigned num_games=1000;
+unsigned grid_size=7;
+unsigned num_threads=0; // 0: one per hardware thread
+unsigned search_depth=1;
+unsigned opening_plies=4;
+double sample_rate=1;
+unsigned seed=time(NULL);
+string output_file="selfplay.dat";
+string network_file;
+string weights_file;
+
+
+void parse_args(int argc, char *argv[]);
+/*
+ * Description: Parses command line arguments, sets associated flags.
+ * Parameters:
+ *    int argc - argc that is passed into main()
+ *    int argv - argv that is passed into main()
+ */
+
+
+void help(string binary_name, string options);
+/*
+ * Description: Prints usage message if -h or --help flags arguments
+ *              are passed on the command line.
+ */
+
+
+int main(int argc, char *argv[]) {
+  parse_args(argc, argv);
+
+  alphabeta_agent::agent::set_depth(search_depth);
+
+  // Evaluate with a network instead of mobility.
+  nnue_network network;
+  if(!network_file.empty()) {
+    if(!network.load(network_file)) {
+      cerr << "Error: Could not load network " << network_file << "." << endl;
+      return 1;
+    }
+    alphabeta_agent::agent::set_network(&network);
+  }
+
+  // Tuned weights are read by each agent as it is constructed.
+  if(!weights_file.empty()) {
+    eval_weights weights;
+    if(!weights.load(weights_file)) {
+      cerr << "Error: Could not load weights " << weights_file << "." << endl;
+      return 1;
+    }
+    alphabeta_agent::agent::set_weights_file(weights_file);
+  }
+
+  selfplay<alphabeta_agent::agent>
+    generator(num_games, grid_size,
+	      num_threads ? num_threads : thread_pool::default_threads(),
+	      output_file);
+  generator.set_opening_plies(opening_plies);
+  generator.set_sample_rate(sample_rate);
+  generator.set_seed(seed);
+
+  if(!generator.run()) {
+    cerr << "Error: Could not write " << output_file << "." << endl;
+    return 1;
+  }
+
+  return 0;
+}
+
+
+void parse_args(int argc, char *argv[]) {
+  int option;
+  opterr = 0;
+
+  // getopt_long arguments
+  string options = "d:f:g:hj:n:";
+  const struct option long_options[] =
+    {
+      {"depth",       required_argument,  0, 'd'},
+      {"file",        required_argument,  0, 'f'},
+      {"grid",        required_argument,  0, 'g'},
+      {"help",        no_argument,        0, 'h'},
+      {"threads",     required_argument,  0, 'j'},
+      {"games",       required_argument,  0, 'n'},
+      {"openings",    required_argument,  0, 'O'},
+      {"sample",      required_argument,  0, 'S'},
+      {"seed",        required_argument,  0, 'D'},
+      {"network",     required_argument,  0, 'N'},
+      {"weights",     required_argument,  0, 'E'},
+      {0,0,0,0},
+    };
+  int option_index;
+
+  option = getopt_long(argc, argv, options.c_str(),
+		       long_options, &option_index);
+
+  while(option != -1) {
+    switch(option) {
+    case 'd':
+      // Search depth of the agent
+      search_depth = atoi(optarg);
+      break;
+    case 'f':
+      // Output file
+      output_file = optarg;
+      break;
+    case 'g':
+      // Grid size flag
+      grid_size = atoi(optarg);
+      break;
+    case 'h':
+      // Help flag
+      help(argv[0], options);
+      exit(0);
+      break;
+    case 'j':
+      // Number of worker threads
+      num_threads = atoi(optarg);
+      break;
+    case 'n':
+      // Number of games to play
+      num_games = atoi(optarg);
+      break;
+    case 'O':
+      // Random opening length (long option only)
+      opening_plies = atoi(optarg);
+      break;
+    case 'S':
+      // Fraction of positions recorded (long option only)
+      sample_rate = atof(optarg);
+      break;
+    case 'D':
+      // Seed (long option only)
+      seed = strtoul(optarg, NULL, 10);
+      break;
+    case 'N':
+      // Network evaluation (long option only)
+      network_file = optarg;
+      break;
+    case 'E':
+      // Evaluation weights (long option only)
+      weights_file = optarg;
+      break;
+    case '?':
+      cerr << "Error: Unrecognized argument or missing value." << endl
+	   << "See the -h option for usage." << endl;
+      exit(0);
+      break;
+    default:
+      cerr << "Error: Unknown argument: " << char(option) << endl;
+      exit(0);
+      break;
+    }
+
+    option = getopt_long(argc, argv, options.c_str(),
+			 long_options, &option_index);
+  }
+}
+
+
+void help(string binary_name, string options) {
+  options.erase(remove(options.begin(), options.end(), ':'), options.end());
+
+  cout << bold << "NAME\n\t" << binary_name << regular << " -- generates labelled isola positions by self-play" << endl
+       << bold << "SYNOPSIS: \n\t" << binary_name
+       << " [-" << options << "]" << regular << endl
+       << bold << "OPTIONS:" << regular << endl
+       << bold << "-d | --depth n" << regular
+       << "        Search depth of the alpha-beta agent (default: 1)." << endl
+       << bold << "-f | --file name" << regular
+       << "      Output record file (default: selfplay.dat)." << endl
+       << bold << "-g | --grid n" << regular
+       << "         Sets gameboard size to " << bold << 'n' << regular << 'x' << bold << 'n' << regular << '.' << endl
+       << bold << "-h | --help" << regular
+       << "           Print this help." << endl
+       << bold << "-j | --threads n" << regular
+       << "      Uses " << bold << 'n' << regular << " worker threads (default: all hardware threads)." << endl
+       << bold << "-n | --games n" << regular
+       << "        Plays " << bold << 'n' << regular << " games (default: 1000)." << endl
+       << bold << "--openings n" << regular
+       << "          Starts each game with " << bold << 'n' << regular << " random moves (default: 4)." << endl
+       << bold << "--sample p" << regular
+       << "            Records each position with probability " << bold << 'p' << regular << " (default: 1)." << endl
+       << bold << "--seed n" << regular
+       << "              Seeds the games (default: time)." << endl
+       << bold << "--network file" << regular
+       << "        Evaluates with the network in " << bold << "file" << regular << " instead of mobility." << endl
+       << bold << "--weights file" << regular
+       << "        Evaluates with the weights in " << bold << "file" << regular << " (see tune)." << endl;
+}
@@ -0,0 +1,286 @@
+/*
+ * File: selfplay.h
+ * Author: Joshua T. Guerin
+ * Purpose: Generates labelled training positions by self-play.  A search
+ *          agent plays itself from random openings on every core; sampled
+ *          positions are labelled with the agent's search score and the
+ *          game's final result and streamed to a record file (records.h).
+ *          Games are played by tournament::run_simulation(), so a game
+ *          seed gives the same game here as in a tournament.
+ *
+ * Note: This is a templated class (the template parameter is the agent,
+ *       which must provide score() in addition to the usual agent
+ *       contract, e.g., alphabeta_agent::agent).  As such there is no
+ *       selfplay.cpp class implementation; selfplay.cpp is the driver.
+ */
+
+#ifndef SELFPLAY_H
+#define SELFPLAY_H
+
+#include <atomic>             // Game counter
+#include <chrono>             // Progress reports
+#include <condition_variable> // Bounded record queue
+#include <deque>              // Bounded record queue
+#include <iostream>           // Console io
+#include <mutex>              // Bounded record queue
+#include <random>             // Seeded openings/sampling
+#include <string>             // File name
+#include <thread>             // Writer thread
+#include <utility>            // move()
+#include <vector>             // Records of one game
+
+#include "agent_traits.h" // Optional agent hooks
+#include "isola.h"        // Game logic
+#include "records.h"      // Record file format
+#include "thread_pool.h"  // Game workers
+#include "tournament.h"   // Game loop
+#include "types.h"        // Isola/tournament types.
+
+
+template <typename TAgent>
+class selfplay {
+  /*
+   * Self-play class: Plays total_games games of TAgent against itself and
+   *                  writes sampled positions to output_file.
+   */
+ private:
+  // Generation flags/data
+  unsigned total_games;
+  unsigned board_size;
+  unsigned num_threads;
+  unsigned opening_plies;
+  double sample_rate;
+  unsigned base_seed;
+  std::string output_file;
+
+  // Finished games waiting to be written.  At most queue_limit games are
+  // buffered, so memory stays bounded however fast the workers are.
+  std::deque<std::vector<position_record> > pending;
+  unsigned queue_limit;
+  bool workers_done;
+  std::mutex queue_lock;
+  std::condition_variable queue_not_full, queue_not_empty;
+
+  std::atomic<unsigned> next_game;
+
+  struct position_sampler {
+    /*
+     * Move observer (see tournament::run_simulation()) that records each
+     * position before an agent move with probability rate.
+     */
+    std::mt19937 rng;
+    std::uniform_real_distribution<double> sample;
+    double rate;
+    std::vector<position_record> records;
+
+    position_sampler(unsigned seed, double sample_rate);
+
+    void operator()(isola& game, player to_move, TAgent& mover,
+		    const action&) {
+      if(sample(rng) < rate)
+	records.push_back(position_record(game, to_move, mover.score()));
+    }
+  };
+
+  void play_games();
+  /*
+   * Description: Worker loop: plays games until all have been started.
+   */
+
+  std::vector<position_record> play_game(tournament<TAgent, TAgent>& games,
+					 unsigned seed);
+  /*
+   * Description: Plays one seeded game of games and returns its sampled,
+   *              labelled positions.
+   */
+
+  unsigned long long write_records(record_writer& out);
+  /*
+   * Description: Writer loop: drains the queue to out, reporting progress
+   *              on cerr.  Returns the number of records written.
+   */
+
+ public:
+  selfplay(unsigned num_games, unsigned grid_size, unsigned threads,
+	   const std::string& filename);
+  /*
+   * Description: Constructs a generator of num_games games on a
+   *              grid_size board using threads worker threads.
+   */
+
+  void set_opening_plies(unsigned plies) { opening_plies = plies; }
+  /*
+   * Description: Number of random moves played (and not recorded) at
+   *              the start of each game, for variety.  (Default: 4)
+   */
+
+  void set_sample_rate(double rate) { sample_rate = rate; }
+  /*
+   * Description: Probability that any one position is recorded.
+   *              (Default: 1)
+   */
+
+  void set_seed(unsigned seed) { base_seed = seed; }
+
+  bool run();
+  /*
+   * Description: Plays every game and writes the record file.
+   *
+   * Returns:
+   *     false - the output file could not be created or written (see
+   *             record_writer::good()).
+   */
+};
+
+
+template <typename TAgent>
+selfplay<TAgent>::selfplay(unsigned num_games, unsigned grid_size,
+			   unsigned threads, const std::string& filename)
+  : output_file(filename), next_game(0) {
+  total_games = num_games;
+  board_size = grid_size;
+  num_threads = threads;
+  opening_plies = 4;
+  sample_rate = 1;
+  base_seed = 0;
+  queue_limit = 4 * threads;
+  workers_done = false;
+}
+
+
+template <typename TAgent>
+bool selfplay<TAgent>::run() {
+  record_writer out(output_file, board_size);
+  if(!out.is_open())
+    return false;
+
+  unsigned long long written = 0;
+  std::thread writer([this, &out, &written]() {
+      written = write_records(out);
+    });
+
+  {
+    thread_pool pool(num_threads);
+
+    // One long-running task per worker; games are handed out by counter.
+    for(unsigned i=0; i<pool.size(); i++)
+      pool.submit([this]() { play_games(); });
+    pool.wait();
+  }
+
+  {
+    std::lock_guard<std::mutex> guard(queue_lock);
+    workers_done = true;
+  }
+  queue_not_empty.notify_all();
+  writer.join();
+
+  if(!out.close())
+    return false;
+
+  std::cerr << "Wrote " << written << " positions from " << total_games
+	    << " games to " << output_file << "." << std::endl;
+  return true;
+}
+
+
+template <typename TAgent>
+selfplay<TAgent>::position_sampler::position_sampler(unsigned seed,
+						     double sample_rate)
+  : sample(0, 1), rate(sample_rate) {
+  // Independent of the game's own generator, which is also seeded with
+  // seed (tournament::run_simulation()).
+  std::seed_seq sampler_seed{seed, 1u};
+  rng.seed(sampler_seed);
+}
+
+
+template <typename TAgent>
+void selfplay<TAgent>::play_games() {
+  // Quiet games with this generator's board and openings.
+  tournament<TAgent, TAgent> games(1, false, false, false, board_size);
+  games.set_opening_plies(opening_plies);
+
+  for(unsigned game = next_game++; game < total_games; game = next_game++) {
+    std::vector<position_record> records = play_game(games, base_seed + game);
+
+    std::unique_lock<std::mutex> guard(queue_lock);
+    while(pending.size() >= queue_limit)
+      queue_not_full.wait(guard);
+    pending.push_back(std::vector<position_record>());
+    pending.back().swap(records);
+    queue_not_empty.notify_one();
+  }
+}
+
+
+template <typename TAgent>
+std::vector<position_record>
+selfplay<TAgent>::play_game(tournament<TAgent, TAgent>& games,
+			    unsigned seed) {
+  // run_simulation() draws the first mover, plays the random opening (not
+  // recorded) and seeds the agents (seeds.h), all from seed.
+  position_sampler sampler(seed, sample_rate);
+  round_winner winner = games.run_simulation(seed, false, sampler);
+  std::vector<position_record>& records = sampler.records;
+
+  // Label every sampled position with the result for its side to move.
+  for(unsigned i=0; i<records.size(); i++) {
+    if(winner.black && winner.white)
+      records[i].result = 0;
+    else if(winner.black == (records[i].to_move == black))
+      records[i].result = 1;
+    else
+      records[i].result = -1;
+  }
+
+  return std::move(records);
+}
+
+
+template <typename TAgent>
+unsigned long long selfplay<TAgent>::write_records(record_writer& out) {
+  unsigned long long written = 0;
+  unsigned games = 0;
+  std::chrono::steady_clock::time_point start =
+    std::chrono::steady_clock::now();
+  std::chrono::steady_clock::time_point last_report = start;
+
+  while(true) {
+    std::vector<position_record> records;
+    {
+      std::unique_lock<std::mutex> guard(queue_lock);
+      while(pending.empty() && !workers_done)
+	queue_not_empty.wait(guard);
+      if(pending.empty())
+	break;
+      records.swap(pending.front());
+      pending.pop_front();
+    }
+    queue_not_full.notify_one();
+
+    for(unsigned i=0; i<records.size(); i++)
+      out.write(records[i]);
+    written += records.size();
+    games++;
+
+    // No more games once a write fails (the queue is still drained, so
+    // the workers finish).
+    if(!out.good())
+      next_game = total_games;
+
+    std::chrono::steady_clock::time_point now =
+      std::chrono::steady_clock::now();
+    if(now - last_report > std::chrono::seconds(5)) {
+      double seconds = std::chrono::duration<double>(now - start).count();
+      std::cerr << games << "/" << total_games << " games, " << written
+		<< " positions (" << int(written / seconds * 3600)
+		<< " positions/hour)" << std::endl;
+      last_report = now;
+    }
+  }
+
+  return written;
+}
+
+#endif
@@ -0,0 +1,239 @@
+/*
+ * File: solve.cpp
+ * Author: Joshua T. Guerin
+ * Purpose: Driver for the df-pn solver (see solver.h).
+ *          Solves the start position of a small board for each first
+ *          mover (or a given position), reporting the value, a move that
+ *          achieves it, nodes and nodes/second.  Solved positions can be
+ *          loaded from and saved to a file, so that later runs (or larger
+ *          questions) start from them.
+ *
+ * Limits: 3x3 (a first-mover win) and 4x4 (a tie) solve in seconds.  5x5
+ *         runs at about 55k nodes/s per thread and has not been solved;
+ *         use --nodes and --save to bound and keep a partial run.
+ */
+
+
+#include <iostream>  // console io
+#include <getopt.h>  // getopt()
+#include <cstdlib>   // atoi(), atof()
+#include <algorithm> // remove()
+
+#include "solver.h"      // df-pn solver
+#include "thread_pool.h" // default_threads()
+#include "types.h"       // Types associated with game/tournament.
+
+using namespace std;
+
+// Solver Flags
+unsigned grid_size=4;
+unsigned num_threads=0; // 0: one per hardware thread
+unsigned table_megabytes=256;
+unsigned long long node_limit=0;
+double report_interval=1;
+string start_position; // Text form (isola::to_text()), if given
+string load_file, save_file;
+
+void parse_args(int argc, char *argv[]);
+/*
+ * Description: Parses command line arguments, sets associated flags.
+ */
+
+
+void help(string binary_name, string options);
+/*
+ * Description: Prints usage message if -h or --help flags arguments
+ *              are passed on the command line.
+ */
+
+
+bool report(pn_solver& solver, isola board, player to_move);
+/*
+ * Description: Solves board with to_move to move and prints the result.
+ *              Returns false if the node limit stopped the search.
+ */
+
+
+int main(int argc, char *argv[]) {
+  parse_args(argc, argv);
+
+  pn_solver solver(table_megabytes);
+  solver.set_threads(num_threads ? num_threads :
+		     thread_pool::default_threads());
+  solver.set_node_limit(node_limit);
+  solver.set_progress(&cout, report_interval);
+
+  isola board(grid_size);
+  player to_move = black;
+  if(!start_position.empty()) {
+    if(!isola::from_text(start_position, board, to_move)) {
+      cerr << "Error: Not a valid position: " << start_position << endl;
+      return 1;
+    }
+    grid_size = board.max_rows();
+  }
+
+  if(!load_file.empty()) {
+    if(!solver.load(load_file, grid_size)) {
+      cerr << "Error: Could not load " << load_file << " (or it is not for "
+	   << grid_size << 'x' << grid_size << " boards)." << endl;
+      return 1;
+    }
+    cout << bold << "Loaded: " << regular << solver.solved_count()
+	 << " solved positions" << endl;
+  }
+
+  cout << bold << "Table: " << regular << solver.table_entries()
+       << " entries" << endl;
+
+  bool solved = report(solver, board, to_move);
+  if(start_position.empty() && solved)
+    solved = report(solver, board, white);
+
+  if(!save_file.empty()) {
+    if(!solver.save(save_file, grid_size)) {
+      cerr << "Error: Could not write " << save_file << "." << endl;
+      return 1;
+    }
+    cout << bold << "Saved: " << regular << solver.solved_count()
+	 << " solved positions to " << save_file << endl;
+  }
+
+  return solved ? 0 : 1;
+}
+
+
+bool report(pn_solver& solver, isola board, player to_move) {
+  const char* names[2] = {"black", "white"};
+
+  cout << bold << "Position: " << regular << board.to_text(to_move) << endl;
+  solution result = solver.solve(board, to_move);
+
+  cout << bold << "Value: " << regular;
+  if(!result.solved)
+    cout << "unknown (node limit reached)";
+  else if(result.value == 0)
+    cout << "tie";
+  else
+    cout << names[(result.value > 0) == (to_move == white) ? 1 : 0]
+	 << " wins";
+  if(result.has_best)
+    cout << " (" << direction_names[result.best.move_to] << ", remove "
+	 << result.best.remove.row << ' ' << result.best.remove.col << ')';
+  cout << endl
+       << bold << "Search: " << regular << result.nodes << " nodes, "
+       << result.seconds << " s, " << result.nodes / result.seconds
+       << " nodes/s" << endl;
+
+  return result.solved;
+}
+
+
+void parse_args(int argc, char *argv[]) {
+  int option;
+  opterr = 0;
+
+  // getopt_long arguments
+  string options = "g:hj:m:";
+  const struct option long_options[] =
+    {
+      {"grid",        required_argument,  0, 'g'},
+      {"help",        no_argument,        0, 'h'},
+      {"threads",     required_argument,  0, 'j'},
+      {"memory",      required_argument,  0, 'm'},
+      {"load",        required_argument,  0, 'L'},
+      {"save",        required_argument,  0, 'S'},
+      {"nodes",       required_argument,  0, 'N'},
+      {"interval",    required_argument,  0, 'I'},
+      {"position",    required_argument,  0, 'P'},
+      {0,0,0,0},
+    };
+  int option_index;
+
+  option = getopt_long(argc, argv, options.c_str(),
+		       long_options, &option_index);
+
+  while(option != -1) {
+    switch(option) {
+    case 'g':
+      // Grid size flag
+      grid_size = atoi(optarg);
+      break;
+    case 'h':
+      // Help flag
+      help(argv[0], options);
+      exit(0);
+      break;
+    case 'j':
+      // Number of search threads
+      num_threads = atoi(optarg);
+      break;
+    case 'm':
+      // Table size in MB
+      table_megabytes = atoi(optarg);
+      break;
+    case 'L':
+      // Solved positions to start from (long option only)
+      load_file = optarg;
+      break;
+    case 'S':
+      // Solved positions to write (long option only)
+      save_file = optarg;
+      break;
+    case 'N':
+      // Node limit (long option only)
+      node_limit = strtoull(optarg, NULL, 10);
+      break;
+    case 'I':
+      // Seconds between progress reports (long option only)
+      report_interval = atof(optarg);
+      break;
+    case 'P':
+      // Position to solve (long option only)
+      start_position = optarg;
+      break;
+    case '?':
+      cerr << "Error: Unrecognized argument or missing value." << endl
+	   << "See the -h option for usage." << endl;
+      exit(0);
+      break;
+    default:
+      cerr << "Error: Unknown argument: " << char(option) << endl;
+      exit(0);
+      break;
+    }
+
+    option = getopt_long(argc, argv, options.c_str(),
+			 long_options, &option_index);
+  }
+}
+
+
+void help(string binary_name, string options) {
+  options.erase(remove(options.begin(), options.end(), ':'), options.end());
+
+  cout << bold << "NAME\n\t" << binary_name << regular << " -- solves small isola positions with proof-number search" << endl
+       << bold << "SYNOPSIS: \n\t" << binary_name
+       << " [-" << options << "]" << regular << endl
+       << bold << "OPTIONS:" << regular << endl
+       << bold << "-g | --grid n" << regular
+       << "         Solves the " << bold << 'n' << regular << 'x' << bold << 'n' << regular << " start position for each first mover" << endl
+       << "                      (default: 4).  3x3 and 4x4 take seconds; 5x5 has" << endl
+       << "                      not been solved (bound it with --nodes)." << endl
+       << bold << "-h | --help" << regular
+       << "           Print this help." << endl
+       << bold << "-j | --threads n" << regular
+       << "      Searches on " << bold << 'n' << regular << " threads (default: all hardware threads)." << endl
+       << bold << "-m | --memory n" << regular
+       << "       Bounds the transposition table to " << bold << 'n' << regular << " MB (default: 256)." << endl
+       << bold << "--interval s" << regular
+       << "          Reports progress every " << bold << 's' << regular << " seconds (default: 1; 0: never)." << endl
+       << bold << "--load file" << regular
+       << "           Starts from the solved positions in " << bold << "file" << regular << '.' << endl
+       << bold << "--nodes n" << regular
+       << "             Gives up after " << bold << 'n' << regular << " nodes per position." << endl
+       << bold << "--position text" << regular
+       << "       Solves " << bold << "text" << regular << " (see isola::to_text()) instead." << endl
+       << bold << "--save file" << regular
+       << "           Writes the solved positions to " << bold << "file" << regular << '.' << endl;
+}
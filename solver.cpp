@@ -0,0 +1,472 @@
+/*
+ * File: solver.cpp
+ * Author: Joshua T. Guerin
+ * Description: Implementation of the df-pn solver.  See solver.h.
+ */
+
+#include <algorithm>          // copy()
+#include <chrono>             // Progress, timing
+#include <condition_variable> // Progress reports while searching
+#include <cstdio>             // Solved files
+#include <cstring>            // memcmp()
+
+#include "solver.h"
+#include "symmetry.h"    // Canonical hashes, symmetric moves
+#include "thread_pool.h" // Search threads
+
+using namespace std;
+
+static const char solved_magic[8] = {'I','S','O','L','A','P','N','S'};
+
+// Proof/disproof number of a solved node.
+static const uint32_t pn_infinity = 0x7fffffff;
+
+// The table key of "at least tie" questions differs from "win".
+static const uint64_t tie_question_key = 0x9e3779b97f4a7c15ULL;
+
+
+static void put_u32(unsigned char* out, uint32_t value) {
+  for(unsigned i=0; i<4; i++)
+    out[i] = (value >> (8*i)) & 0xff;
+}
+
+static void put_u64(unsigned char* out, uint64_t value) {
+  put_u32(out, value & 0xffffffff);
+  put_u32(out + 4, value >> 32);
+}
+
+static uint32_t get_u32(const unsigned char* in) {
+  return in[0] | (in[1] << 8) | (in[2] << 16) | (uint32_t(in[3]) << 24);
+}
+
+static uint64_t get_u64(const unsigned char* in) {
+  return get_u32(in) | (uint64_t(get_u32(in + 4)) << 32);
+}
+
+
+static bool meets_goal(game_outcome result, player p, bool strict) {
+  // Whether a finished game answers p's question with yes.
+  if(result == tied)
+    return !strict;
+  return (result == black_won) == (p == black);
+}
+
+
+pn_solver::pn_solver(unsigned megabytes)
+  : locks(num_locks), used(0), num_threads(1), node_limit(0), progress(0),
+    progress_interval(1), nodes(0), stop(false), root_key(0), root_proof(1),
+    root_disproof(1) {
+  // A power of two number of buckets, at least one.
+  uint64_t buckets = 1;
+  while(buckets * 2 * bucket_size * sizeof(entry) <=
+	uint64_t(megabytes) << 20)
+    buckets *= 2;
+
+  table.assign(buckets * bucket_size, entry());
+  for(unsigned i=0; i<table.size(); i++)
+    table[i].key = 0;
+  bucket_mask = buckets - 1;
+}
+
+
+uint64_t pn_solver::table_key(const uint64_t hashes[8], bool strict) {
+  uint64_t key = canonicalize(hashes).hash;
+  if(!strict)
+    key ^= tie_question_key;
+  return key ? key : 1;
+}
+
+
+pn_solver::entry* pn_solver::find(uint64_t key, bool insert) {
+  entry* bucket = &table[(key & bucket_mask) * bucket_size];
+  entry* victim = 0;
+
+  for(unsigned i=0; i<bucket_size; i++) {
+    entry& e = bucket[i];
+    if(e.key == key)
+      return &e;
+    if(!insert)
+      continue;
+
+    // Empty entries first, then unsolved ones, then the least searched.
+    if(e.key == 0) {
+      if(victim == 0 || victim->key != 0)
+	victim = &e;
+      continue;
+    }
+    if(victim != 0 && victim->key == 0)
+      continue;
+
+    bool solved = e.proof == 0 || e.disproof == 0;
+    bool victim_solved = victim != 0 &&
+      (victim->proof == 0 || victim->disproof == 0);
+    if(victim == 0 || (victim_solved && !solved) ||
+       (victim_solved == solved && e.work < victim->work))
+      victim = &e;
+  }
+
+  if(victim != 0) {
+    if(victim->key == 0)
+      used++;
+    victim->key = key;
+    victim->proof = victim->disproof = 1;
+    victim->work = 0;
+    victim->busy = 0;
+  }
+  return victim;
+}
+
+
+bool pn_solver::lookup(uint64_t key, uint32_t& proof, uint32_t& disproof,
+		       uint32_t& busy) {
+  lock_guard<mutex> guard(locks[(key & bucket_mask) % num_locks]);
+  entry* e = find(key, false);
+  if(e == 0)
+    return false;
+
+  proof = e->proof;
+  disproof = e->disproof;
+  busy = e->busy;
+  return true;
+}
+
+
+void pn_solver::store(uint64_t key, uint32_t proof, uint32_t disproof,
+		      uint32_t work) {
+  lock_guard<mutex> guard(locks[(key & bucket_mask) % num_locks]);
+  entry* e = find(key, true);
+
+  // A thread that was stopped part way may store stale values over a
+  // node another thread has solved.
+  if(e->proof != 0 && e->disproof != 0) {
+    e->proof = proof;
+    e->disproof = disproof;
+  }
+  e->work = (e->work > 0xffffffff - work) ? 0xffffffff : e->work + work;
+}
+
+
+void pn_solver::enter(uint64_t key) {
+  lock_guard<mutex> guard(locks[(key & bucket_mask) % num_locks]);
+  find(key, true)->busy++;
+}
+
+
+void pn_solver::leave(uint64_t key) {
+  lock_guard<mutex> guard(locks[(key & bucket_mask) % num_locks]);
+  entry* e = find(key, false);
+  if(e != 0 && e->busy > 0)
+    e->busy--;
+}
+
+
+uint32_t pn_solver::search(isola& board, player to_move, bool strict,
+			   const uint64_t hashes[8], uint32_t proof_limit,
+			   uint32_t disproof_limit, uint32_t& proof,
+			   uint32_t& disproof) {
+  struct child {
+    action move;
+    uint64_t hashes[num_symmetries];
+    uint64_t key;
+    bool terminal;
+    uint32_t proof, disproof;
+  };
+
+  player opponent = (to_move == black) ? white : black;
+  unsigned n = board.max_rows();
+  location from = board.find_player(to_move);
+  uint64_t key = table_key(hashes, strict);
+  vector<action> actions = board.legal_actions(to_move);
+  unsigned symmetries = board_symmetries(board);
+  vector<child> children;
+  children.reserve(actions.size());
+  uint32_t busy = 0;
+
+  // Each child answers the other question for the opponent: to_move wins
+  // unless the opponent at least ties, and at least ties unless the
+  // opponent wins.
+  for(unsigned i=0; i<actions.size(); i++) {
+    if(symmetries != 1 && has_equivalent_before(actions, i, symmetries, n))
+      continue;
+
+    isola next = board;
+    next.move(to_move, actions[i].move_to, actions[i].remove);
+    child c;
+    c.move = actions[i];
+    c.key = 0;
+    game_outcome result = next.game_result();
+    c.terminal = result != playing;
+    if(c.terminal) {
+      bool yes = meets_goal(result, opponent, !strict);
+      c.proof = yes ? 0 : pn_infinity;
+      c.disproof = yes ? pn_infinity : 0;
+    }
+    else {
+      for(unsigned s=0; s<num_symmetries; s++)
+	c.hashes[s] = hashes[s];
+      update_symmetric_hashes(c.hashes, n, to_move, from,
+			      next.find_player(to_move), actions[i].remove);
+      c.key = table_key(c.hashes, !strict);
+
+      // Unsearched children start from their mobility (as in df-pn+): the
+      // more moves a side has left, the harder it is to beat.  Squared,
+      // this halves the nodes to solve 4x4 against starting from 1.
+      unsigned mine = next.mobility(to_move), theirs = next.mobility(opponent);
+      c.proof = 1 + mine * mine;
+      c.disproof = 1 + theirs * theirs;
+      __builtin_prefetch(&table[(c.key & bucket_mask) * bucket_size]);
+    }
+    children.push_back(c);
+  }
+
+  // Looked up once all are generated, so that the table reads overlap.
+  for(unsigned i=0; i<children.size(); i++)
+    if(!children[i].terminal)
+      lookup(children[i].key, children[i].proof, children[i].disproof, busy);
+
+  uint32_t work = 1;
+  nodes++;
+
+  while(true) {
+    // The node is proven by one disproven child, and disproven once every
+    // child is proven.  Children are searched most-proving first.
+    uint64_t proof_sum = 0;
+    uint32_t min_disproof = pn_infinity;
+    uint64_t best_value = pn_infinity, second_value = pn_infinity;
+    unsigned best = 0;
+
+    // With one thread a child only changes when it is searched (below);
+    // other threads may change any of them.
+    for(unsigned i=0; i<children.size(); i++) {
+      child& c = children[i];
+      busy = 0;
+      if(num_threads > 1 && !c.terminal)
+	lookup(c.key, c.proof, c.disproof, busy);
+
+      proof_sum += c.proof;
+      if(c.disproof < min_disproof)
+	min_disproof = c.disproof;
+
+      uint64_t value = uint64_t(c.disproof) * (1 + busy);
+      if(value < best_value) {
+	second_value = best_value;
+	best_value = value;
+	best = i;
+      }
+      else if(value < second_value)
+	second_value = value;
+    }
+
+    proof = min_disproof;
+    disproof = proof_sum >= pn_infinity ? pn_infinity : uint32_t(proof_sum);
+    if(key == root_key) {
+      root_proof = proof;
+      root_disproof = disproof;
+    }
+    if(proof >= proof_limit || disproof >= disproof_limit || stop)
+      break;
+
+    // Thresholds of df-pn, with the 1+epsilon trick (epsilon = 1/4) so
+    // the search stays longer in one child.
+    child& c = children[best];
+    uint32_t child_proof_limit = disproof_limit - disproof + c.proof;
+    uint64_t child_disproof_limit = second_value + second_value / 4 + 1;
+    if(child_disproof_limit > proof_limit)
+      child_disproof_limit = proof_limit;
+
+    isola next = board;
+    next.move(to_move, c.move.move_to, c.move.remove);
+    if(num_threads > 1)
+      enter(c.key);
+    work += search(next, opponent, !strict, c.hashes, child_proof_limit,
+		   uint32_t(child_disproof_limit), c.proof, c.disproof);
+    if(num_threads > 1)
+      leave(c.key);
+
+    if(node_limit != 0 && nodes >= node_limit)
+      stop = true;
+  }
+
+  store(key, proof, disproof, work);
+  return work;
+}
+
+
+bool pn_solver::prove(isola& board, player to_move, bool strict,
+		      bool& proven) {
+  uint64_t hashes[num_symmetries];
+  symmetric_hashes(board, to_move, hashes);
+  root_key = table_key(hashes, strict);
+  root_proof = root_disproof = 1;
+
+  uint32_t solved_proof = 1, solved_disproof = 1;
+  mutex report_lock;
+  condition_variable finished;
+  unsigned running = num_threads;
+
+  stop = false;
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  unsigned long long start_nodes = nodes;
+
+  {
+    thread_pool pool(num_threads);
+    for(unsigned t=0; t<num_threads; t++)
+      pool.submit([&]() {
+	  isola root = board;
+	  uint32_t proof, disproof;
+	  search(root, to_move, strict, hashes, pn_infinity, pn_infinity,
+		 proof, disproof);
+
+	  // The first thread back has solved the root (or hit the limit).
+	  lock_guard<mutex> guard(report_lock);
+	  if(proof == 0 || disproof == 0) {
+	    solved_proof = proof;
+	    solved_disproof = disproof;
+	  }
+	  stop = true;
+	  running--;
+	  finished.notify_all();
+	});
+
+    unique_lock<mutex> guard(report_lock);
+    while(running > 0) {
+      if(progress == 0 || progress_interval <= 0) {
+	finished.wait(guard);
+	continue;
+      }
+      if(finished.wait_for(guard, chrono::duration<double>(progress_interval))
+	 != cv_status::timeout)
+	continue;
+
+      double seconds = chrono::duration<double>(chrono::steady_clock::now() -
+						start).count();
+      *progress << "  " << seconds << " s: " << nodes - start_nodes
+		<< " nodes (" << (nodes - start_nodes) / seconds
+		<< " nodes/s), root proof/disproof " << root_proof << '/'
+		<< root_disproof << ", table " << 100.0 * used / table.size()
+		<< "% full" << endl;
+    }
+    guard.unlock();
+    pool.wait();
+  }
+
+  proven = solved_proof == 0;
+  return solved_proof == 0 || solved_disproof == 0;
+}
+
+
+solution pn_solver::solve(isola& board, player to_move) {
+  solution result;
+  result.solved = true;
+  result.value = 0;
+  result.has_best = false;
+  nodes = 0;
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+  game_outcome outcome = board.game_result();
+  if(outcome != playing) {
+    result.value = meets_goal(outcome, to_move, true) ? 1 :
+      (outcome == tied ? 0 : -1);
+  }
+  else {
+    // Win?  If not, at least a tie?
+    bool win = false, tie = false;
+    result.solved = prove(board, to_move, true, win);
+    if(result.solved && !win)
+      result.solved = prove(board, to_move, false, tie);
+    result.value = win ? 1 : (tie ? 0 : -1);
+
+    // A move that achieves the value leads to a disproven child.
+    vector<action> actions = board.legal_actions(to_move);
+    player opponent = (to_move == black) ? white : black;
+    location from = board.find_player(to_move);
+    uint64_t root_hashes[num_symmetries], hashes[num_symmetries];
+    symmetric_hashes(board, to_move, root_hashes);
+    bool strict = win;
+    for(unsigned i=0; result.solved && result.value >= 0 &&
+	  !result.has_best && i<actions.size(); i++) {
+      isola next = board;
+      next.move(to_move, actions[i].move_to, actions[i].remove);
+      game_outcome child_outcome = next.game_result();
+      uint32_t proof = 1, disproof = 1, busy;
+
+      if(child_outcome != playing)
+	result.has_best = !meets_goal(child_outcome, opponent, !strict);
+      else {
+	copy(root_hashes, root_hashes + num_symmetries, hashes);
+	update_symmetric_hashes(hashes, board.max_rows(), to_move, from,
+				next.find_player(to_move), actions[i].remove);
+	if(lookup(table_key(hashes, !strict), proof, disproof, busy))
+	  result.has_best = disproof == 0;
+      }
+      if(result.has_best)
+	result.best = actions[i];
+    }
+  }
+
+  result.nodes = nodes;
+  result.seconds = chrono::duration<double>(chrono::steady_clock::now() -
+					    start).count();
+  return result;
+}
+
+
+bool pn_solver::load(const string& filename, unsigned n) {
+  FILE* file = fopen(filename.c_str(), "rb");
+  if(file == NULL)
+    return false;
+
+  unsigned char header[20], record[9];
+  if(fread(header, 1, sizeof(header), file) != sizeof(header) ||
+     memcmp(header, solved_magic, 8) != 0 ||
+     get_u32(header + 8) != SOLVED_VERSION || get_u32(header + 12) != n) {
+    fclose(file);
+    return false;
+  }
+
+  uint32_t count = get_u32(header + 16);
+  bool ok = true;
+  for(uint32_t i=0; i<count && ok; i++) {
+    ok = fread(record, 1, sizeof(record), file) == sizeof(record);
+    if(ok)
+      store(get_u64(record), record[8] ? 0 : pn_infinity,
+	    record[8] ? pn_infinity : 0, 0xffffffff);
+  }
+
+  fclose(file);
+  return ok;
+}
+
+
+bool pn_solver::save(const string& filename, unsigned n) {
+  FILE* file = fopen(filename.c_str(), "wb");
+  if(file == NULL)
+    return false;
+
+  unsigned char header[20], record[9];
+  memcpy(header, solved_magic, 8);
+  put_u32(header + 8, SOLVED_VERSION);
+  put_u32(header + 12, n);
+  put_u32(header + 16, solved_count());
+  bool ok = fwrite(header, 1, sizeof(header), file) == sizeof(header);
+
+  for(unsigned i=0; i<table.size() && ok; i++) {
+    const entry& e = table[i];
+    if(e.key == 0 || (e.proof != 0 && e.disproof != 0))
+      continue;
+    put_u64(record, e.key);
+    record[8] = e.proof == 0;
+    ok = fwrite(record, 1, sizeof(record), file) == sizeof(record);
+  }
+
+  return fclose(file) == 0 && ok;
+}
+
+
+unsigned long long pn_solver::solved_count() {
+  unsigned long long count = 0;
+  for(unsigned i=0; i<table.size(); i++)
+    count += table[i].key != 0 &&
+      (table[i].proof == 0 || table[i].disproof == 0);
+  return count;
+}
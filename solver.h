@@ -0,0 +1,194 @@
+/*
+ * File: solver.h
+ * Author: Joshua T. Guerin
+ * Purpose: Exact (game-theoretic) values of small isola positions by
+ *          depth-first proof-number search (df-pn), e.g., the 3x3 and
+ *          4x4 start positions (5x5 is out of reach, see solve.cpp).
+ *          A solved value is the strongest possible test of an agent: it
+ *          says which side wins with perfect play.
+ *
+ * Method: Proof-number search answers yes/no questions, so a position is
+ *         solved with (at most) two: "does the side to move win?" and, if
+ *         not, "does the side to move at least tie?".  A node's question
+ *         alternates with the side to move (the side to move wins unless
+ *         the opponent at least ties, and so on).  Proof and disproof
+ *         numbers are kept in a fixed-size transposition table keyed on
+ *         the canonical position hash (symmetry.h) and the question, so
+ *         equivalent positions are searched once.  Isola positions never
+ *         repeat (every move removes a square), so the search graph is a
+ *         DAG and df-pn needs no cycle handling.
+ *
+ * Threads: Every thread runs df-pn from the root on the shared table.
+ *          Children that other threads are searching look less attractive
+ *          (their disproof numbers are scaled by the number of threads in
+ *          them), which spreads the threads over the tree.
+ *
+ * Solved file format (all integers little-endian):
+ *     header: "ISOLAPNS" (8 bytes), version (u32), board size n (u32),
+ *             number of entries (u32)
+ *     entries: table key (u64), proven (u8: 1 proven, 0 disproven)
+ */
+
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include <atomic>   // Node counts, stop flag
+#include <mutex>    // Table locks
+#include <ostream>  // Progress reports
+#include <stdint.h> // uint64_t
+#include <string>   // File names
+#include <vector>   // Table
+
+#include "isola.h" // Game logic
+#include "types.h" // Isola/tournament types.
+
+#define SOLVED_VERSION 1
+
+
+struct solution {
+  /*
+   * The result of pn_solver::solve().
+   */
+  bool solved;    // false if the node limit was reached first
+  int value;      // For the side to move: 1 win, 0 tie, -1 loss
+  bool has_best;  // Whether best is known (solved, and not a loss)
+  action best;    // A move that achieves value
+  unsigned long long nodes;
+  double seconds;
+};
+
+
+class pn_solver {
+  /*
+   * Description: A df-pn solver with a transposition table of a fixed
+   *              size.  The table (and with it every solved position)
+   *              persists between solve() calls.
+   */
+ private:
+  struct entry {
+    uint64_t key;       // 0: empty
+    uint32_t proof, disproof;
+    uint32_t work;      // Nodes searched below the entry (replacement)
+    uint32_t busy;      // Threads searching below the entry
+  };
+
+  static const unsigned bucket_size = 4;
+  static const unsigned num_locks = 4096;
+
+  std::vector<entry> table;
+  uint64_t bucket_mask;
+  std::vector<std::mutex> locks;
+  std::atomic<unsigned long long> used;
+
+  unsigned num_threads;
+  unsigned long long node_limit;
+  std::ostream* progress;
+  double progress_interval;
+
+  std::atomic<unsigned long long> nodes;
+  std::atomic<bool> stop;
+
+  // The question being proven, and its numbers as last computed.
+  uint64_t root_key;
+  std::atomic<uint32_t> root_proof, root_disproof;
+
+  uint64_t table_key(const uint64_t hashes[8], bool strict);
+  /*
+   * Description: The table key of the question (strict: does the side to
+   *              move win; otherwise: does it at least tie) on the
+   *              position with the given symmetric_hashes().
+   */
+
+  bool lookup(uint64_t key, uint32_t& proof, uint32_t& disproof,
+	      uint32_t& busy);
+  void store(uint64_t key, uint32_t proof, uint32_t disproof,
+	     uint32_t work);
+  void enter(uint64_t key);
+  void leave(uint64_t key);
+  /*
+   * Description: Table access.  lookup() leaves its arguments unchanged
+   *              if key is not in the table.  enter()/leave() count the
+   *              threads searching below key.
+   */
+
+  entry* find(uint64_t key, bool insert);
+  /*
+   * Description: key's entry, or (if insert) the entry replaced to make
+   *              room for it (empty, else the least searched unsolved
+   *              entry of the bucket, else the least searched), or 0.
+   *              The caller holds the bucket's lock.
+   */
+
+  uint32_t search(isola& board, player to_move, bool strict,
+		  const uint64_t hashes[8], uint32_t proof_limit,
+		  uint32_t disproof_limit, uint32_t& proof,
+		  uint32_t& disproof);
+  /*
+   * Description: df-pn: searches below board (whose symmetric_hashes() are
+   *              hashes) until its proof number
+   *              reaches proof_limit or its disproof number reaches
+   *              disproof_limit (or the search is stopped), stores and
+   *              returns them in proof/disproof.  Returns the number of
+   *              nodes searched.
+   */
+
+  bool prove(isola& board, player to_move, bool strict, bool& proven);
+  /*
+   * Description: Answers the question (see table_key()) for board on every
+   *              thread, reporting progress.  Returns false if stopped by
+   *              the node limit.
+   */
+
+ public:
+  pn_solver(unsigned megabytes);
+  /*
+   * Description: A solver whose table uses (at most) megabytes MB.
+   */
+
+  void set_threads(unsigned threads) { num_threads = threads ? threads : 1; }
+  void set_node_limit(unsigned long long limit) { node_limit = limit; }
+  /*
+   * Description: Stops a solve() after limit nodes (0: no limit).
+   */
+
+  void set_progress(std::ostream* out, double seconds) {
+    progress = out;
+    progress_interval = seconds;
+  }
+  /*
+   * Description: Reports nodes, nodes/second, the root's proof and
+   *              disproof numbers and the table's use to out every
+   *              seconds (out = 0: never).
+   */
+
+  solution solve(isola& board, player to_move);
+  /*
+   * Description: The value of board with to_move to move, under perfect
+   *              play by both sides.
+   */
+
+  bool load(const std::string& filename, unsigned n);
+  /*
+   * Description: Adds the solved positions in filename to the table.
+   *              They are kept in preference to anything searched.
+   *
+   * Returns:
+   *     false - filename could not be read, or is for another board size
+   *             than nxn.
+   */
+
+  bool save(const std::string& filename, unsigned n);
+  /*
+   * Description: Writes every solved position in the table (nxn boards)
+   *              to filename.
+   */
+
+  unsigned long long solved_count();
+  /*
+   * Description: Solved positions (and questions) in the table.
+   */
+
+  unsigned long long table_entries() { return table.size(); }
+};
+
+#endif
@@ -0,0 +1,192 @@
+/*
+ * File: sprt.h
+ * Author: Joshua T. Guerin
+ * Purpose: Sequential probability ratio test for comparing two agents.
+ *          Games are added one at a time and the test stops as soon as
+ *          one of the two Elo hypotheses is accepted:
+ *              H0: agent elo difference == elo0
+ *              H1: agent elo difference == elo1
+ *
+ * Notes: The log-likelihood ratio is the generalized (maximum likelihood)
+ *        one of the trinomial (win/tie/loss) model: under each hypothesis
+ *        the win/tie/loss probabilities are the most likely ones given
+ *        the games whose expected score is s0 (or s1), and
+ *            LLR = sum over outcomes of n_i log(p1_i / p0_i).
+ *        Unlike the normal approximation n (s1 - s0) (2 s - s0 - s1) /
+ *        (2 var) it needs no variance estimate, so it keeps growing (and
+ *        the test stops) when every game so far has had the same result.
+ *        Outcomes not yet seen are counted as 0.001 games, as in fishtest.
+ *        Paired games (tournament::use_paired_games()) are not
+ *        independent, so they are added as pairs instead, and the LLR is
+ *        then the pentanomial one over pair scores 0, 0.5, 1, 1.5 and 2.
+ */
+
+#ifndef SPRT_H
+#define SPRT_H
+
+#include <cmath> // log()
+
+#include "elo.h" // match_score, score_from_elo()
+
+
+enum sprt_result {
+  // Outcome of the test so far.
+  sprt_continue, sprt_accept_h0, sprt_accept_h1
+};
+
+
+class sprt {
+  /*
+   * Description: Tracks one agent's results and the resulting LLR.
+   */
+ private:
+  double elo0, elo1;
+  double alpha, beta;
+  match_score results;
+  // pairs[k]: pairs scoring k half points, if games are added in pairs.
+  unsigned pairs[5];
+  bool paired;
+
+  static double log_likelihood(const double* counts, const double* scores,
+			       double* probabilities, unsigned outcomes,
+			       double s);
+  /*
+   * Description: Sets probabilities to the most likely distribution of
+   *              the outcomes (outcome i scoring scores[i], seen counts[i]
+   *              times) with expected score s.
+   *
+   * Preconditions: Every count is positive, the scores span 0 to 1 and
+   *                0 < s < 1.
+   */
+
+ public:
+  sprt() : elo0(0), elo1(5), alpha(0.05), beta(0.05),
+	   pairs{0, 0, 0, 0, 0}, paired(false) {}
+
+  sprt(double e0, double e1, double a, double b)
+    : elo0(e0), elo1(e1), alpha(a), beta(b), pairs{0, 0, 0, 0, 0},
+      paired(false) {}
+  /*
+   * Description: H0: elo == e0, H1: elo == e1.  a and b are the
+   *              probabilities of falsely accepting H1 and H0 respectively.
+   */
+
+  void add(const match_score& games) { results += games; }
+  /*
+   * Description: Adds one or more finished games (e.g., a parallel batch).
+   */
+
+  void add_win()  { results.wins++; }
+  void add_tie()  { results.ties++; }
+  void add_loss() { results.losses++; }
+
+  void add_pair(const match_score& pair) {
+    /*
+     * Description: Adds the two games of one pair.  Once pairs are added,
+     *              llr() is over pairs (do not mix with single games).
+     */
+    results += pair;
+    pairs[2*pair.wins + pair.ties]++;
+    paired = true;
+  }
+
+  void add_pairs(const unsigned* counts, const match_score& games) {
+    /*
+     * Description: Adds counts[k] pairs scoring k half points, k = 0..4,
+     *              made of games (e.g., from a checkpoint).
+     */
+    results += games;
+    for(unsigned k=0; k<5; k++) {
+      pairs[k] += counts[k];
+      paired = paired || counts[k] > 0;
+    }
+  }
+
+  const unsigned* pair_scores() const { return pairs; }
+
+  double lower_bound() const { return std::log(beta / (1 - alpha)); }
+  double upper_bound() const { return std::log((1 - beta) / alpha); }
+
+  const match_score& score() const { return results; }
+
+  double llr() const {
+    /*
+     * Description: Log-likelihood ratio of H1 versus H0 for the games
+     *              added so far.
+     */
+    if(results.games() == 0)
+      return 0;
+
+    // Outcome scores: per game, or per pair (its mean score).
+    static const double game_scores[3] = {0, 0.5, 1};
+    static const double pair_scores[5] = {0, 0.25, 0.5, 0.75, 1};
+    const double* scores = paired ? pair_scores : game_scores;
+    unsigned outcomes = paired ? 5 : 3;
+    double counts[5], p0[5], p1[5];
+
+    if(paired)
+      for(unsigned k=0; k<5; k++)
+	counts[k] = pairs[k];
+    else {
+      counts[0] = results.losses;
+      counts[1] = results.ties;
+      counts[2] = results.wins;
+    }
+
+    for(unsigned i=0; i<outcomes; i++)
+      if(counts[i] == 0)
+	counts[i] = 1e-3;
+    log_likelihood(counts, scores, p0, outcomes, score_from_elo(elo0));
+    log_likelihood(counts, scores, p1, outcomes, score_from_elo(elo1));
+
+    double ratio = 0;
+    for(unsigned i=0; i<outcomes; i++)
+      ratio += counts[i] * std::log(p1[i] / p0[i]);
+    return ratio;
+  }
+
+  sprt_result status() const {
+    double ratio = llr();
+    if(ratio >= upper_bound())
+      return sprt_accept_h1;
+    if(ratio <= lower_bound())
+      return sprt_accept_h0;
+    return sprt_continue;
+  }
+
+  double h0_elo() const { return elo0; }
+  double h1_elo() const { return elo1; }
+};
+
+
+inline double sprt::log_likelihood(const double* counts, const double* scores,
+				   double* probabilities, unsigned outcomes,
+				   double s) {
+  // Lagrange multipliers: p_i = f_i / (1 + lambda (scores[i] - s)), f_i
+  // the observed frequencies, where lambda makes the p_i sum to 1, i.e.,
+  // sum f_i (scores[i] - s) / (1 + lambda (scores[i] - s)) = 0.  The sum
+  // falls as lambda rises from -1/(1 - s) to 1/s, so bisect.
+  double total = 0;
+  for(unsigned i=0; i<outcomes; i++)
+    total += counts[i];
+
+  double low = -1 / (1 - s), high = 1 / s;
+  for(unsigned step=0; step<200; step++) {
+    double lambda = (low + high) / 2, sum = 0;
+    for(unsigned i=0; i<outcomes; i++)
+      sum += counts[i] * (scores[i] - s) / (1 + lambda * (scores[i] - s));
+    if(sum > 0)
+      low = lambda;
+    else
+      high = lambda;
+  }
+
+  double lambda = (low + high) / 2, likelihood = 0;
+  for(unsigned i=0; i<outcomes; i++) {
+    probabilities[i] = counts[i] / total / (1 + lambda * (scores[i] - s));
+    likelihood += counts[i] * std::log(probabilities[i]);
+  }
+  return likelihood;
+}
+
+#endif
@@ -0,0 +1,212 @@
+/*
+ * File: symmetry.cpp
+ * Author: Joshua T. Guerin
+ * Description: Board symmetries and canonical hashes.  See symmetry.h for
+ *              details.
+ */
+
+#include "symmetry.h"
+
+using namespace std;
+
+// Zobrist key kinds.
+enum key_kind { removed_key, black_key, white_key, side_key };
+
+static uint64_t zobrist_key(key_kind kind, unsigned square, unsigned n) {
+  // splitmix64 of (size, kind, square): well-mixed keys for any board size
+  // without a table per size.
+  uint64_t z = (uint64_t(n) << 40 | uint64_t(kind) << 32 | square) +
+    0x9e3779b97f4a7c15ULL;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+// Row and column steps of each direction (in enum order).
+static const int row_step[8] = {-1, 1, 0, 0, -1, -1, 1, 1};
+static const int col_step[8] = {0, 0, 1, -1, -1, 1, -1, 1};
+
+
+location transform_location(location l, unsigned symmetry, unsigned n) {
+  unsigned row = l.row, col = l.col;
+
+  if(symmetry & 4)
+    swap(row, col);
+  if(symmetry & 1)
+    col = n - 1 - col;
+  if(symmetry & 2)
+    row = n - 1 - row;
+  return location(row, col);
+}
+
+
+direction transform_direction(direction d, unsigned symmetry) {
+  int row = row_step[d], col = col_step[d];
+
+  if(symmetry & 4)
+    swap(row, col);
+  if(symmetry & 1)
+    col = -col;
+  if(symmetry & 2)
+    row = -row;
+
+  for(int t=north; t<=southeast; t++)
+    if(row_step[t] == row && col_step[t] == col)
+      return direction(t);
+  return d; // Unreachable
+}
+
+
+action transform_action(const action& a, unsigned symmetry, unsigned n) {
+  return action(transform_direction(a.move_to, symmetry),
+		transform_location(a.remove, symmetry, n));
+}
+
+
+unsigned inverse_symmetry(unsigned symmetry) {
+  // Mirroring after a transpose is the same as transposing after the
+  // other mirror, so undoing a transposing symmetry swaps the mirrors.
+  if(symmetry & 4)
+    return 4 | ((symmetry & 1) << 1) | ((symmetry & 2) >> 1);
+  return symmetry;
+}
+
+
+isola transform_board(isola& board, unsigned symmetry) {
+  unsigned n = board.max_rows();
+  vector<vector<char> > squares(n, vector<char>(n));
+
+  for(unsigned i=0; i<n; i++)
+    for(unsigned j=0; j<n; j++) {
+      location to = transform_location(location(i, j), symmetry, n);
+      squares[to.row][to.col] = board[i][j];
+    }
+  return isola(squares);
+}
+
+
+uint64_t position_hash(isola& board, player to_move) {
+  unsigned n = board.max_rows();
+  uint64_t hash = to_move == black ? 0 : zobrist_key(side_key, 0, n);
+
+  for(unsigned i=0; i<n; i++) {
+    const vector<char>& row = board[i];
+    for(unsigned j=0; j<n; j++)
+      if(row[j] == 'X')
+	hash ^= zobrist_key(removed_key, i*n + j, n);
+  }
+
+  location b = board.find_player(black), w = board.find_player(white);
+  hash ^= zobrist_key(black_key, b.row*n + b.col, n);
+  hash ^= zobrist_key(white_key, w.row*n + w.col, n);
+  return hash;
+}
+
+
+void symmetric_hashes(isola& board, player to_move,
+		      uint64_t hashes[num_symmetries]) {
+  unsigned n = board.max_rows();
+  uint64_t side = to_move == black ? 0 : zobrist_key(side_key, 0, n);
+
+  for(unsigned s=0; s<num_symmetries; s++)
+    hashes[s] = side;
+
+  for(unsigned i=0; i<n; i++) {
+    const vector<char>& row = board[i];
+    for(unsigned j=0; j<n; j++) {
+      key_kind kind;
+      if(row[j] == 'X')
+	kind = removed_key;
+      else if(row[j] == black)
+	kind = black_key;
+      else if(row[j] == white)
+	kind = white_key;
+      else
+	continue;
+
+      for(unsigned s=0; s<num_symmetries; s++) {
+	location to = transform_location(location(i, j), s, n);
+	hashes[s] ^= zobrist_key(kind, to.row*n + to.col, n);
+      }
+    }
+  }
+}
+
+
+uint64_t update_position_hash(uint64_t hash, unsigned n, player p,
+			      location from, location to, location removed) {
+  key_kind pawn = p == black ? black_key : white_key;
+
+  return hash ^ zobrist_key(side_key, 0, n) ^
+    zobrist_key(pawn, from.row*n + from.col, n) ^
+    zobrist_key(pawn, to.row*n + to.col, n) ^
+    zobrist_key(removed_key, removed.row*n + removed.col, n);
+}
+
+
+void update_symmetric_hashes(uint64_t hashes[num_symmetries], unsigned n,
+			     player p, location from, location to,
+			     location removed) {
+  for(unsigned s=0; s<num_symmetries; s++)
+    hashes[s] = update_position_hash(hashes[s], n, p,
+				     transform_location(from, s, n),
+				     transform_location(to, s, n),
+				     transform_location(removed, s, n));
+}
+
+
+canonical_position canonicalize(isola& board, player to_move) {
+  uint64_t hashes[num_symmetries];
+
+  symmetric_hashes(board, to_move, hashes);
+  return canonicalize(hashes);
+}
+
+
+canonical_position canonicalize(const uint64_t hashes[num_symmetries]) {
+  canonical_position canonical;
+
+  canonical.hash = hashes[0];
+  canonical.symmetry = 0;
+  for(unsigned s=1; s<num_symmetries; s++)
+    if(hashes[s] < canonical.hash) {
+      canonical.hash = hashes[s];
+      canonical.symmetry = s;
+    }
+  return canonical;
+}
+
+
+unsigned board_symmetries(isola& board) {
+  unsigned n = board.max_rows();
+  unsigned mask = 1;
+
+  for(unsigned s=1; s<num_symmetries; s++) {
+    bool same = true;
+    for(unsigned i=0; i<n && same; i++)
+      for(unsigned j=0; j<n && same; j++) {
+	location to = transform_location(location(i, j), s, n);
+	same = board[to.row][to.col] == board[i][j];
+      }
+    if(same)
+      mask |= 1 << s;
+  }
+  return mask;
+}
+
+
+bool has_equivalent_before(const vector<action>& actions, unsigned i,
+			   unsigned symmetries, unsigned n) {
+  for(unsigned s=1; s<num_symmetries; s++) {
+    if(!(symmetries & (1 << s)))
+      continue;
+
+    action image = transform_action(actions[i], s, n);
+    for(unsigned j=0; j<i; j++)
+      if(actions[j].move_to == image.move_to &&
+	 actions[j].remove.row == image.remove.row &&
+	 actions[j].remove.col == image.remove.col)
+	return true;
+  }
+  return false;
+}
@@ -0,0 +1,141 @@
+/*
+ * File: symmetry.h
+ * Author: Joshua T. Guerin
+ * Purpose: The 8 symmetries of the square board (rotations and
+ *          reflections) applied to squares, directions, actions and whole
+ *          positions, and canonical position hashes: equivalent positions
+ *          (the same up to a symmetry) share one canonical hash, so tables
+ *          keyed on it (transpositions, opening books, endgame caches)
+ *          store each position once.
+ *
+ * Symmetries: Numbered 0-7.  Symmetry s maps (row, col) by transposing
+ *             (swapping row and col) if s & 4, then mirroring the columns
+ *             if s & 1, then mirroring the rows if s & 2.  0 is the
+ *             identity, 1 the left-right mirror (under which the start
+ *             position is unchanged).  Pawn colours and the side to move
+ *             are never changed.
+ *
+ * Notes: Hashes are Zobrist hashes (a key per removed square, per pawn
+ *        location and for the side to move, combined with xor).  Keys
+ *        are derived from the board size too, so boards of different
+ *        sizes never share a hash.
+ */
+
+#ifndef SYMMETRY_H
+#define SYMMETRY_H
+
+#include <stdint.h> // uint64_t
+#include <vector>   // Action lists
+
+#include "isola.h" // Game logic
+#include "types.h" // Isola/tournament types.
+
+const unsigned num_symmetries = 8;
+
+
+location transform_location(location l, unsigned symmetry, unsigned n);
+/*
+ * Description: Square l of an nxn board under symmetry.
+ */
+
+direction transform_direction(direction d, unsigned symmetry);
+/*
+ * Description: The direction d points in once the board is transformed.
+ */
+
+action transform_action(const action& a, unsigned symmetry, unsigned n);
+/*
+ * Description: a as played on the transformed board: if a is legal for p
+ *              on board, the result is legal for p on
+ *              transform_board(board, symmetry), and leads to the
+ *              transformed successor.
+ */
+
+unsigned inverse_symmetry(unsigned symmetry);
+/*
+ * Description: The symmetry that undoes symmetry (each is its own
+ *              inverse except the two quarter turns, 5 and 6).
+ */
+
+isola transform_board(isola& board, unsigned symmetry);
+/*
+ * Description: A copy of board with every square (and both pawns) moved
+ *              by symmetry.
+ */
+
+
+uint64_t position_hash(isola& board, player to_move);
+/*
+ * Description: The Zobrist hash of board with to_move to move (not
+ *              canonical: equivalent positions hash differently).
+ */
+
+uint64_t update_position_hash(uint64_t hash, unsigned n, player p,
+			      location from, location to, location removed);
+/*
+ * Description: The position_hash() of the successor when p's pawn moves
+ *              from from to to and removes removed (and the other side is
+ *              to move), from hash, the hash before the move.
+ */
+
+void symmetric_hashes(isola& board, player to_move,
+		      uint64_t hashes[num_symmetries]);
+/*
+ * Description: hashes[s] = position_hash(transform_board(board, s),
+ *              to_move) for every symmetry, in a single pass over the
+ *              board (no transformed boards are built).
+ */
+
+void update_symmetric_hashes(uint64_t hashes[num_symmetries], unsigned n,
+			     player p, location from, location to,
+			     location removed);
+/*
+ * Description: Updates hashes (from symmetric_hashes()) for p's pawn
+ *              moving from from to to and removing removed, with the
+ *              other side to move next: the hashes of the successor,
+ *              without a pass over its board.
+ */
+
+
+struct canonical_position {
+  /*
+   * The canonical hash of a position and the symmetry that maps the
+   * position onto its canonical form.
+   */
+  uint64_t hash;
+  unsigned symmetry;
+};
+
+canonical_position canonicalize(isola& board, player to_move);
+canonical_position canonicalize(const uint64_t hashes[num_symmetries]);
+/*
+ * Description: The smallest of the position's 8 symmetric hashes, and
+ *              the symmetry that gives it (the lowest such symmetry if the
+ *              position is itself symmetric).  The second form picks it
+ *              from hashes already computed by symmetric_hashes().
+ *
+ * Notes: Actions stored against a canonical hash should be in the
+ *        canonical frame: store transform_action(a, c.symmetry, n), and
+ *        map a stored action back to the position being searched with
+ *        transform_action(stored, inverse_symmetry(c.symmetry), n).
+ */
+
+
+unsigned board_symmetries(isola& board);
+/*
+ * Description: The symmetries that leave board (squares and both pawns)
+ *              unchanged, as a bit mask: bit s is set if
+ *              transform_board(board, s) equals board.  Bit 0 is always
+ *              set.
+ */
+
+bool has_equivalent_before(const std::vector<action>& actions, unsigned i,
+			   unsigned symmetries, unsigned n);
+/*
+ * Description: Checks whether some symmetry in symmetries (a mask from
+ *              board_symmetries()) maps actions[i] onto one of
+ *              actions[0 ... i-1].  Such actions lead to equivalent
+ *              positions, so a search only needs the first of each.
+ */
+
+#endif
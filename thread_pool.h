@@ -0,0 +1,212 @@
+/*
+ * File: thread_pool.h
+ * Author: Joshua T. Guerin
+ * Purpose: A small work-stealing thread pool used to play many isola games
+ *          in parallel (e.g., league play).
+ *
+ * Note: Each worker owns a deque of tasks.  A worker pops work from the
+ *       back of its own deque and, when it runs dry, steals from the front
+ *       of the other workers' deques.  Submitted tasks are dealt to the
+ *       workers round-robin.
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>             // Outstanding task counter, shutdown flag
+#include <condition_variable> // Sleeping workers/waiters
+#include <deque>              // Per-worker task queues
+#include <functional>         // std::function tasks
+#include <memory>             // unique_ptr for per-worker queues
+#include <mutex>              // Queue locks
+#include <thread>             // Worker threads
+#include <vector>             // Worker/queue storage
+
+
+class thread_pool {
+  /*
+   * Description: Runs submitted tasks on a fixed set of worker threads.
+   *              Idle workers steal tasks from busy workers' queues.
+   */
+ private:
+  struct work_queue {
+    std::mutex lock;
+    std::deque<std::function<void()> > tasks;
+  };
+
+  std::vector<std::unique_ptr<work_queue> > queues;
+  std::vector<std::thread> workers;
+
+  // Tasks submitted but not yet finished, used by wait().
+  std::atomic<unsigned> outstanding;
+  std::atomic<unsigned> next_queue;
+  std::atomic<bool> stopping;
+
+  // Idle workers and wait() callers sleep on these.
+  std::mutex sleep_lock;
+  std::condition_variable work_available;
+  std::condition_variable all_done;
+
+  bool pop_local(unsigned id, std::function<void()>& task);
+  /*
+   * Description: Takes the most recently submitted task from worker id's
+   *              own queue (LIFO keeps the worker's data warm).
+   */
+
+  bool steal(unsigned id, std::function<void()>& task);
+  /*
+   * Description: Takes the oldest task from any other worker's queue,
+   *              starting with worker id's neighbour.
+   */
+
+  void worker_loop(unsigned id);
+  /*
+   * Description: Body of each worker thread: run local work, then steal,
+   *              then sleep until more work arrives or the pool stops.
+   */
+
+ public:
+  explicit thread_pool(unsigned num_threads);
+  /*
+   * Description: Starts num_threads workers (at least one).
+   */
+
+  ~thread_pool();
+  /*
+   * Description: Finishes all queued tasks and joins the workers.
+   */
+
+  void submit(std::function<void()> task);
+  /*
+   * Description: Queues task to be run by some worker.
+   */
+
+  void wait();
+  /*
+   * Description: Blocks until every submitted task has finished.
+   */
+
+  unsigned size() const { return workers.size(); }
+  /*
+   * Description: Returns the number of worker threads.
+   */
+
+  static unsigned default_threads();
+  /*
+   * Description: Returns the number of hardware threads (at least 1).
+   */
+};
+
+
+inline thread_pool::thread_pool(unsigned num_threads)
+  : outstanding(0), next_queue(0), stopping(false) {
+  if(num_threads == 0)
+    num_threads = 1;
+
+  for(unsigned i=0; i<num_threads; i++)
+    queues.push_back(std::unique_ptr<work_queue>(new work_queue));
+
+  for(unsigned i=0; i<num_threads; i++)
+    workers.push_back(std::thread(&thread_pool::worker_loop, this, i));
+}
+
+
+inline thread_pool::~thread_pool() {
+  wait();
+
+  {
+    std::lock_guard<std::mutex> guard(sleep_lock);
+    stopping = true;
+  }
+  work_available.notify_all();
+
+  for(unsigned i=0; i<workers.size(); i++)
+    workers[i].join();
+}
+
+
+inline void thread_pool::submit(std::function<void()> task) {
+  unsigned id = next_queue++ % queues.size();
+
+  outstanding++;
+  {
+    std::lock_guard<std::mutex> guard(queues[id]->lock);
+    queues[id]->tasks.push_back(task);
+  }
+
+  // Take the sleep lock so a worker can't miss the wakeup between
+  // checking the queues and going to sleep.
+  std::lock_guard<std::mutex> guard(sleep_lock);
+  work_available.notify_one();
+}
+
+
+inline void thread_pool::wait() {
+  std::unique_lock<std::mutex> guard(sleep_lock);
+  while(outstanding != 0)
+    all_done.wait(guard);
+}
+
+
+inline unsigned thread_pool::default_threads() {
+  unsigned n = std::thread::hardware_concurrency();
+  return n == 0 ? 1 : n;
+}
+
+
+inline bool thread_pool::pop_local(unsigned id, std::function<void()>& task) {
+  std::lock_guard<std::mutex> guard(queues[id]->lock);
+  if(queues[id]->tasks.empty())
+    return false;
+
+  task = queues[id]->tasks.back();
+  queues[id]->tasks.pop_back();
+  return true;
+}
+
+
+inline bool thread_pool::steal(unsigned id, std::function<void()>& task) {
+  for(unsigned i=1; i<queues.size(); i++) {
+    work_queue& victim = *queues[(id + i) % queues.size()];
+    std::lock_guard<std::mutex> guard(victim.lock);
+    if(!victim.tasks.empty()) {
+      task = victim.tasks.front();
+      victim.tasks.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+
+inline void thread_pool::worker_loop(unsigned id) {
+  std::function<void()> task;
+
+  while(true) {
+    if(pop_local(id, task) || steal(id, task)) {
+      task();
+      task = nullptr;
+
+      if(--outstanding == 0) {
+	std::lock_guard<std::mutex> guard(sleep_lock);
+	all_done.notify_all();
+      }
+      continue;
+    }
+
+    // Nothing to run anywhere: sleep until new work or shutdown.  Queued
+    // work is re-checked under the sleep lock (see submit()).
+    std::unique_lock<std::mutex> guard(sleep_lock);
+    if(stopping)
+      return;
+    bool found = false;
+    for(unsigned i=0; i<queues.size() && !found; i++) {
+      std::lock_guard<std::mutex> queue_guard(queues[i]->lock);
+      found = !queues[i]->tasks.empty();
+    }
+    if(!found)
+      work_available.wait(guard);
+  }
+}
+
+#endif
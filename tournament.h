@@ -8,13 +8,38 @@
  * 
  * Note: This is a templated class (template parameters are agent AI classes).
  *       As such there is no tournament.cpp.
+ *       Built with ISOLA_PROFILE, run() ends with the hot-path counters of
+ *       its games (see profile.h).
  */
 
-#include "isola.h" // Game board/logic
-#include "types.h" // Types for isola game/tournament logic.
+#ifndef TOURNAMENT_H
+#define TOURNAMENT_H
+
+#include <cmath>    // sqrt()
+#include <cstdlib>  // rand()
+#include <iostream> // Console io
+#include <random>   // mt19937 for seeded games/openings
+#include <string>   // Checkpoint file
+
+#include "agent_traits.h" // Optional agent hooks
+#include "checkpoint.h"   // Resumable runs
+#include "elo.h"          // Paired-game statistics
+#include "isola.h"        // Game board/logic
+#include "profile.h"      // Optional hot-path counters
+#include "seeds.h"        // Agents' seeds for each game
+#include "sprt.h"         // Sequential early stopping
+#include "types.h"        // Types for isola game/tournament logic.
 
 using namespace std;
 
+struct no_move_observer {
+  /*
+   * Move observer (see tournament::run_simulation()) that does nothing.
+   */
+  template <typename TAgent>
+  void operator()(isola&, player, TAgent&, const action&) {}
+};
+
 template <typename TBlackAgent, typename TWhiteAgent>
 class tournament {
   /*
@@ -32,6 +57,72 @@ class tournament {
   bool pause_between_moves;
   bool display_winner;
   unsigned board_size;
+
+  // Sequential probability ratio test (black agent vs. white agent).
+  bool sequential_test;
+  sprt test;
+
+  // Paired scheduling: each seed/opening is played twice with the agents'
+  // colors swapped.  Openings are opening_plies random legal moves.
+  bool paired_games;
+  unsigned opening_plies;
+
+  // Agents with a ponder() hook think during the opponent's turn.
+  bool pondering;
+
+  // Checkpoints: the state of the run is written to checkpoint_file every
+  // checkpoint_interval games (see checkpoint.h), and a run can continue
+  // from one (resumed).  Game i of a run is seeded with base seed + i
+  // whether or not it is checkpointed.
+  std::string checkpoint_file;
+  unsigned checkpoint_interval;
+  bool resuming;
+  tournament_checkpoint resumed;
+
+  tournament_checkpoint checkpoint_settings();
+  /*
+   * Description: A checkpoint of this tournament (agents and settings)
+   *              before any game is played.
+   */
+
+  bool checkpoint_due(unsigned games_played, unsigned& last_checkpoint);
+  /*
+   * Description: Whether checkpoint_interval games have been played since
+   *              the game count last_checkpoint (which is then updated).
+   */
+
+  void save_checkpoint(const tournament_checkpoint& state);
+  /*
+   * Description: Writes state to checkpoint_file, warning on cerr if it
+   *              cannot be written (the run goes on).
+   */
+
+  void run_paired();
+  /*
+   * Description: run() for paired scheduling.  Plays pairs of games and
+   *              reports statistics over pairs.
+   */
+
+  template <typename TObserver>
+  round_winner play_game(player first, bool swap_colors, mt19937& rng,
+			 TObserver& observer);
+  /*
+   * Description: Plays a single game of isola in which first moves first.
+   *              If swap_colors is set, TBlackAgent plays the white pawn
+   *              and TWhiteAgent the black pawn.  rng generates the random
+   *              opening (if any).  observer sees every agent move (see
+   *              run_simulation()).
+   *
+   * Returns:
+   *     The winner by pawn color.
+   */
+
+  void play_opening(isola& game, player& current_move, mt19937& rng);
+  /*
+   * Description: Applies opening_plies uniformly random legal moves,
+   *              alternating sides from current_move, and updates
+   *              current_move to the side left to move.
+   */
   
  public:
   tournament();
@@ -48,6 +139,57 @@ class tournament {
    *              directly to the private simulation flags of similar names).
    */
   
+  void use_sprt(const sprt& t);
+  /*
+   * Description: Enables early stopping: run() stops as soon as t accepts
+   *              either hypothesis about the black agent's Elo advantage
+   *              over the white agent.  The number of simulations becomes
+   *              the maximum number of games played.
+   */
+
+  void use_paired_games();
+  /*
+   * Description: Enables paired scheduling: each game seed (first mover
+   *              and opening) is played twice, with TBlackAgent playing
+   *              black the first time and white the second.  Moving first
+   *              is therefore swapped between the agents as well.
+   */
+
+  void set_opening_plies(unsigned plies);
+  /*
+   * Description: Starts every game from plies random legal moves.
+   */
+
+  void use_checkpoints(const std::string& filename, unsigned interval);
+  /*
+   * Description: Makes run() write its state (games played, tallies, the
+   *              base seed of its games, the SPRT's games) to filename
+   *              every interval games (paired: at the first pair boundary
+   *              after them) and when it ends.  Checkpointing does not
+   *              change the games played.
+   */
+
+  bool resume(const std::string& filename);
+  /*
+   * Description: Makes run() continue the run checkpointed in filename
+   *              (up to the number of simulations, which may have been
+   *              raised).  Unless use_checkpoints() names another file,
+   *              checkpoints go on being written to filename.
+   *
+   * Returns:
+   *     false - filename could not be read, or was written by a
+   *             tournament with other agents, board size, openings,
+   *             scheduling or SPRT (call use_sprt() etc. first).
+   */
+
+  void use_pondering();
+  /*
+   * Description: Enables pondering: after each move, an agent with a
+   *              ponder() hook (see agent_traits.h) keeps searching on a
+   *              background thread until its opponent has moved.  Games
+   *              are then no longer exactly reproducible from a seed.
+   */
+
   void run();
   /*
    * Description: Runs a complete isola tournament based on the simulation
@@ -60,9 +202,30 @@ class tournament {
   
   round_winner run_simulation();
   /*
-   * Description: Simulates a single game of isola.
+   * Description: Simulates a single game of isola, seeded from rand().
    * 
    * Notes: Starting player is randomly selected with uniform probability.
+   *        rand() is shared by every thread; games on worker threads
+   *        should be given their own seeds.
+   */
+
+  round_winner run_simulation(unsigned seed, bool swap_colors);
+  /*
+   * Description: Simulates a single, reproducible game of isola.  seed
+   *              chooses the starting player, the opening and the seeds
+   *              of the agents' random choices (see seeds.h).  See
+   *              play_game() for swap_colors.
+   */
+
+  template <typename TObserver>
+  round_winner run_simulation(unsigned seed, bool swap_colors,
+			      TObserver& observer);
+  /*
+   * Description: run_simulation(seed, swap_colors) that calls
+   *              observer(game, mover_color, mover, next) after each agent
+   *              move is chosen, before it is applied (the opening's
+   *              random moves are not observed).  mover is the agent
+   *              itself, e.g., to read its search score (selfplay.h).
    */
   
   inline void clear_screen() { cout << "\033[2J\033[H"; };
@@ -82,6 +245,12 @@ template <typename TBlackAgent, typename TWhiteAgent>
   pause_between_moves=true;
   display_winner=true;
   board_size = 7;
+  sequential_test = false;
+  paired_games = false;
+  opening_plies = 0;
+  pondering = false;
+  checkpoint_interval = 100;
+  resuming = false;
 }
 
 template <typename TBlackAgent, typename TWhiteAgent>
@@ -91,11 +260,101 @@ template <typename TBlackAgent, typename TWhiteAgent>
   pause_between_moves=user_pause;
   display_winner=print_winners;
   board_size = grid_size;
+  sequential_test = false;
+  paired_games = false;
+  opening_plies = 0;
+  pondering = false;
+  checkpoint_interval = 100;
+  resuming = false;
+}
+
+template <typename TBlackAgent, typename TWhiteAgent>
+void tournament<TBlackAgent, TWhiteAgent>::use_sprt(const sprt& t) {
+  sequential_test = true;
+  test = t;
+}
+
+template <typename TBlackAgent, typename TWhiteAgent>
+void tournament<TBlackAgent, TWhiteAgent>::use_paired_games() {
+  paired_games = true;
+}
+
+template <typename TBlackAgent, typename TWhiteAgent>
+void tournament<TBlackAgent, TWhiteAgent>::set_opening_plies(unsigned plies) {
+  opening_plies = plies;
+}
+
+template <typename TBlackAgent, typename TWhiteAgent>
+void tournament<TBlackAgent, TWhiteAgent>::use_pondering() {
+  pondering = true;
+}
+
+template <typename TBlackAgent, typename TWhiteAgent>
+void tournament<TBlackAgent, TWhiteAgent>::use_checkpoints(const std::string& filename, unsigned interval) {
+  checkpoint_file = filename;
+  checkpoint_interval = interval ? interval : 1;
+}
+
+template <typename TBlackAgent, typename TWhiteAgent>
+bool tournament<TBlackAgent, TWhiteAgent>::resume(const std::string& filename) {
+  tournament_checkpoint state;
+  if(!state.load(filename) || !state.same_tournament(checkpoint_settings()))
+    return false;
+
+  resumed = state;
+  resuming = true;
+  if(checkpoint_file.empty())
+    checkpoint_file = filename;
+  return true;
+}
+
+template <typename TBlackAgent, typename TWhiteAgent>
+tournament_checkpoint tournament<TBlackAgent, TWhiteAgent>::checkpoint_settings() {
+  tournament_checkpoint state;
+
+  state.black_name = agent_name_of<TBlackAgent>::name();
+  state.white_name = agent_name_of<TWhiteAgent>::name();
+  state.paired = paired_games;
+  state.grid_size = board_size;
+  state.opening_plies = opening_plies;
+  state.sequential_test = sequential_test;
+  if(sequential_test) {
+    state.elo0 = test.h0_elo();
+    state.elo1 = test.h1_elo();
+    state.lower_bound = test.lower_bound();
+    state.upper_bound = test.upper_bound();
+  }
+  return state;
+}
+
+template <typename TBlackAgent, typename TWhiteAgent>
+bool tournament<TBlackAgent, TWhiteAgent>::checkpoint_due(unsigned games_played, unsigned& last_checkpoint) {
+  if(games_played - last_checkpoint < checkpoint_interval)
+    return false;
+  last_checkpoint = games_played;
+  return true;
+}
+
+template <typename TBlackAgent, typename TWhiteAgent>
+void tournament<TBlackAgent, TWhiteAgent>::save_checkpoint(const tournament_checkpoint& state) {
+  if(!state.save(checkpoint_file))
+    cerr << "Warning: Could not write checkpoint " << checkpoint_file
+	 << "." << endl;
 }
 
 template <typename TBlackAgent, typename TWhiteAgent>
 void tournament<TBlackAgent, TWhiteAgent>::run() {
   int num_wins_black=0, num_wins_white=0;
+  unsigned games_played=0;
+
+  // Hot-path counters (profile.h) cover this run only.
+  profile_reset();
+
+  if(paired_games) {
+    run_paired();
+    profile_report(cout);
+    return;
+  }
 
   // Agents initialized only to get their names for report.
   TBlackAgent player_black(black);
@@ -104,26 +363,89 @@ void tournament<TBlackAgent, TWhiteAgent>::run() {
   // Values returned by each simulation in run_simulation()
   round_winner winner;
 
+  // Each game is seeded from its index, so a run may continue from a
+  // checkpoint.
+  bool checkpointing = !checkpoint_file.empty();
+  tournament_checkpoint state;
+  if(resuming) {
+    state = resumed;
+    games_played = state.games;
+    num_wins_black = state.results.wins;
+    num_wins_white = state.results.losses;
+    if(sequential_test)
+      test.add(state.sprt_games);
+  }
+  else {
+    if(checkpointing)
+      state = checkpoint_settings();
+    state.base_seed = rand();
+  }
+  unsigned last_checkpoint = games_played;
+
   // Run a round of isola, tabulate results.
   // (Number of ties is calculated indirectly.)
-  for(unsigned i=0; i<num_simulations; i++) {
-    winner = run_simulation();
+  for(unsigned i=games_played; i<total_simulations; i++) {
+    // Stop early once the result is statistically settled.
+    if(sequential_test && test.status() != sprt_continue)
+      break;
+
+    winner = run_simulation(state.base_seed + i, false);
+    games_played++;
     if(winner.black && !winner.white)
       num_wins_black++;
     else if(!winner.black && winner.white)
       num_wins_white++;
+
+    if(sequential_test) {
+      if(winner.black && winner.white)
+	test.add_tie();
+      else if(winner.black)
+	test.add_win();
+      else
+	test.add_loss();
+    }
+
+    if(checkpointing) {
+      state.games = games_played;
+      state.results.wins = num_wins_black;
+      state.results.losses = num_wins_white;
+      state.results.ties = games_played - num_wins_black - num_wins_white;
+      state.sprt_games = test.score();
+      if(checkpoint_due(games_played, last_checkpoint))
+	save_checkpoint(state);
+    }
   }
 
+  if(checkpointing)
+    save_checkpoint(state);
+
   // Generate a simulation report based on tournament play.
-  if(num_simulations > 1) {
+  if(games_played > 1) {
     cout << bold << "Generating tournament report..." << regular << endl
-	 << bold << "Total simulations: " << regular << num_simulations << endl
+	 << bold << "Total simulations: " << regular << games_played << endl
 	 << bold << "Total white wins: " << regular << num_wins_white
-      	 << " (" << float(num_wins_white)/num_simulations * 100  << "%)" << endl
+      	 << " (" << float(num_wins_white)/games_played * 100  << "%)" << endl
 	 << bold << "Total black wins: " << regular << num_wins_black
-	 << " (" << float(num_wins_black)/num_simulations * 100  << "%)" << endl
-	 << bold << "Total ties: " << regular << num_simulations-num_wins_black-num_wins_white
-	 << " (" << float(num_simulations - (num_wins_black+num_wins_white))/num_simulations * 100  << "%)" << endl << endl;
+	 << " (" << float(num_wins_black)/games_played * 100  << "%)" << endl
+	 << bold << "Total ties: " << regular << games_played-num_wins_black-num_wins_white
+	 << " (" << float(games_played - (num_wins_black+num_wins_white))/games_played * 100  << "%)" << endl << endl;
+
+    if(sequential_test) {
+      cout << bold << "SPRT: " << regular << "H0: elo = " << test.h0_elo()
+	   << ", H1: elo = " << test.h1_elo()
+	   << " (black, " << player_black.name() << ")" << endl
+	   << bold << "LLR: " << regular << test.llr()
+	   << " [" << test.lower_bound() << ", " << test.upper_bound()
+	   << "]" << endl
+	   << bold << "SPRT result: " << regular;
+      if(test.status() == sprt_accept_h1)
+	cout << "H1 accepted";
+      else if(test.status() == sprt_accept_h0)
+	cout << "H0 accepted";
+      else
+	cout << "inconclusive after " << games_played << " games";
+      cout << endl << endl;
+    }
     
     cout << bold << "And the tournament winner is: " << regular;
     if(num_wins_black > num_wins_white)
@@ -134,24 +456,201 @@ void tournament<TBlackAgent, TWhiteAgent>::run() {
       cout << "a tie";
     cout << endl;
   }
+
+  profile_report(cout);
+}
+
+template <typename TBlackAgent, typename TWhiteAgent>
+void tournament<TBlackAgent, TWhiteAgent>::run_paired() {
+  // Agent a is TBlackAgent, agent b is TWhiteAgent; a's point of view.
+  TBlackAgent player_a(black);
+  TWhiteAgent player_b(white);
+  match_score games_a;
+  // pairs_a[k]: pairs in which agent a scored k half points (0..4).
+  unsigned pairs_a[5] = {0, 0, 0, 0, 0};
+  unsigned pairs_played=0;
+  bool checkpointing = !checkpoint_file.empty();
+  tournament_checkpoint state;
+
+  if(resuming) {
+    state = resumed;
+    games_a = state.results;
+    for(unsigned k=0; k<5; k++)
+      pairs_a[k] = state.pair_scores[k];
+    pairs_played = state.games;
+    if(sequential_test)
+      test.add_pairs(state.pair_scores, state.sprt_games);
+  }
+  else {
+    if(checkpointing)
+      state = checkpoint_settings();
+    state.base_seed = rand();
+  }
+  unsigned base_seed = state.base_seed;
+  unsigned last_checkpoint = 2*pairs_played;
+
+  // -s counts games; each pair is two of them.
+  unsigned total_pairs = (total_simulations + 1) / 2;
+
+  for(unsigned i=pairs_played; i<total_pairs; i++) {
+    round_winner result[2];
+    match_score pair;
+
+    if(sequential_test && test.status() != sprt_continue)
+      break;
+
+    // Same seed (first mover, opening), agents' colors swapped.
+    result[0] = run_simulation(base_seed + i, false);
+    result[1] = run_simulation(base_seed + i, true);
+
+    for(unsigned g=0; g<2; g++) {
+      // Agent a played black in game 0, white in game 1.
+      bool a_won = (g == 0) ? result[g].black : result[g].white;
+      bool b_won = (g == 0) ? result[g].white : result[g].black;
+      if(a_won && b_won)
+	pair.ties++;
+      else if(a_won)
+	pair.wins++;
+      else
+	pair.losses++;
+    }
+
+    games_a += pair;
+    pairs_a[2*pair.wins + pair.ties]++;
+    pairs_played++;
+
+    // The games of a pair are not independent (same seed), so the
+    // sequential test is over pairs.
+    if(sequential_test)
+      test.add_pair(pair);
+
+    if(checkpointing) {
+      state.games = pairs_played;
+      state.results = games_a;
+      for(unsigned k=0; k<5; k++)
+	state.pair_scores[k] = pairs_a[k];
+      state.sprt_games = test.score();
+      if(checkpoint_due(2*pairs_played, last_checkpoint))
+	save_checkpoint(state);
+    }
+  }
+
+  if(checkpointing)
+    save_checkpoint(state);
+
+  if(pairs_played == 0)
+    return;
+
+  // Statistics over pairs: each pair's mean score is one sample, so the
+  // color/first-move advantage and the opening cancel out.
+  double mean = games_a.score();
+  double variance = 0;
+  for(unsigned k=0; k<5; k++)
+    variance += pairs_a[k] * (k/4.0 - mean) * (k/4.0 - mean);
+  variance /= pairs_played;
+  double paired_error = sqrt(variance / pairs_played);
+  double low, high;
+  elo_interval(mean, paired_error, low, high);
+
+  cout << bold << "Generating paired tournament report..." << regular << endl
+       << bold << "Total pairs: " << regular << pairs_played
+       << " (" << 2*pairs_played << " games, colors swapped within each pair";
+  if(opening_plies > 0)
+    cout << ", " << opening_plies << "-ply random openings";
+  cout << ")" << endl
+       << bold << player_a.name() << ": " << regular
+       << games_a.wins << " wins, " << games_a.ties << " ties, "
+       << games_a.losses << " losses" << endl
+       << bold << "Pair scores (0, 0.5, 1, 1.5, 2): " << regular
+       << pairs_a[0] << ", " << pairs_a[1] << ", " << pairs_a[2] << ", "
+       << pairs_a[3] << ", " << pairs_a[4] << endl
+       << bold << "Score: " << regular << mean * 100 << "% +/- "
+       << paired_error * 100 << "% (paired), +/- "
+       << score_std_error(games_a) * 100 << "% (unpaired)" << endl
+       << bold << "Elo: " << regular << elo_from_score(mean)
+       << " [" << low << ", " << high << "] (95%, paired)" << endl << endl;
+
+  if(sequential_test) {
+    cout << bold << "SPRT: " << regular << "H0: elo = " << test.h0_elo()
+	 << ", H1: elo = " << test.h1_elo()
+	 << " (" << player_a.name() << ")" << endl
+	 << bold << "LLR: " << regular << test.llr()
+	 << " [" << test.lower_bound() << ", " << test.upper_bound()
+	 << "]" << endl
+	 << bold << "SPRT result: " << regular;
+    if(test.status() == sprt_accept_h1)
+      cout << "H1 accepted";
+    else if(test.status() == sprt_accept_h0)
+      cout << "H0 accepted";
+    else
+      cout << "inconclusive after " << pairs_played << " pairs";
+    cout << endl << endl;
+  }
+
+  cout << bold << "And the tournament winner is: " << regular;
+  if(games_a.wins > games_a.losses)
+    cout << player_a.name();
+  else if(games_a.losses > games_a.wins)
+    cout << player_b.name();
+  else
+    cout << "a tie";
+  cout << endl;
 }
 
 template <typename TBlackAgent, typename TWhiteAgent>
 round_winner tournament<TBlackAgent, TWhiteAgent>::run_simulation() {
+  return run_simulation(rand(), false);
+}
+
+template <typename TBlackAgent, typename TWhiteAgent>
+round_winner tournament<TBlackAgent, TWhiteAgent>::run_simulation(unsigned seed, bool swap_colors) {
+  no_move_observer observer;
+  return run_simulation(seed, swap_colors, observer);
+}
+
+template <typename TBlackAgent, typename TWhiteAgent>
+template <typename TObserver>
+round_winner tournament<TBlackAgent, TWhiteAgent>::run_simulation(unsigned seed, bool swap_colors, TObserver& observer) {
+  // The game's own choices and its agents' seeds (seeds.h) both come from
+  // seed, so the game replays exactly on any thread.
+  mt19937 rng(seed);
+
+  player first = (rng()%2 == 0) ? black : white;
+  seed_agents(rng());
+  return play_game(first, swap_colors, rng, observer);
+}
+
+template <typename TBlackAgent, typename TWhiteAgent>
+void tournament<TBlackAgent, TWhiteAgent>::play_opening(isola& game, player& current_move, mt19937& rng) {
+  for(unsigned ply=0; ply<opening_plies; ply++) {
+    if(game.game_result() != playing)
+      return;
+
+    // Every legal (direction, removal) pair is equally likely.
+    action next = game.random_action(current_move, rng);
+    game.move(current_move, next.move_to, next.remove);
+    current_move = (current_move == white) ? black : white;
+  }
+}
+
+template <typename TBlackAgent, typename TWhiteAgent>
+template <typename TObserver>
+round_winner tournament<TBlackAgent, TWhiteAgent>::play_game(player first, bool swap_colors, mt19937& rng, TObserver& observer) {
   isola game(board_size);
-  // Default value (is changed randomly in a few lines)
-  player current_move = white;
+  player current_move = first;
   action next;
   round_winner winner;
 
-  // Randomly generate starting color.
-  if(rand()%2 == 0)
-    current_move = black;
-  
-  
-  // Initialize both AI game agents.
-  TBlackAgent player_black(black);
-  TWhiteAgent player_white(white);
+  // Initialize both AI game agents (a: TBlackAgent, b: TWhiteAgent).
+  player a_color = swap_colors ? white : black;
+  TBlackAgent player_a(a_color);
+  TWhiteAgent player_b(swap_colors ? black : white);
+
+  // Declared after the agents so that pondering stops before they are
+  // destroyed.
+  ponderer background;
+
+  play_opening(game, current_move, rng);
   
   if(output_moves | pause_between_moves) {
     cout << bold << "Starting game:" << regular << endl;
@@ -168,7 +667,7 @@ round_winner tournament<TBlackAgent, TWhiteAgent>::run_simulation() {
   }
 
   // Play isola until at least one pawn loses.
-  while(!game.lost_game(black) && !game.lost_game(white)) {
+  while(game.game_result() == playing) {
     if(pause_between_moves)
       cin.get();
 
@@ -183,18 +682,35 @@ round_winner tournament<TBlackAgent, TWhiteAgent>::run_simulation() {
 
     
     // Find/apply next move.
-    if(current_move == black) {
-      next = player_black.next_move(game);
+    if(current_move == a_color) {
+      PROFILE_SCOPE(profile_next_move);
+      next = player_a.next_move(game);
     }
-    else if(current_move == white) {
-      next = player_white.next_move(game);
+    else {
+      PROFILE_SCOPE(profile_next_move);
+      next = player_b.next_move(game);
     }
 
+    // The other agent was pondering; it must stop before it is told the
+    // move.
+    background.stop();
+
+    if(current_move == a_color)
+      observer(game, current_move, player_a, next);
+    else
+      observer(game, current_move, player_b, next);
+
     // Note: In the current implementation if an agent selects
     // an invalid move that player's move (or partial move) is
     // skipped.
     try{
       game.move(current_move, next.move_to, next.remove);
+
+      // Lets search agents reuse their previous search.
+      if(current_move == a_color)
+	notify_opponent_move(player_b, next);
+      else
+	notify_opponent_move(player_a, next);
     }catch(const char* &e) {
       cerr << endl << "-------------" << endl
 	   << e << endl
@@ -208,6 +724,14 @@ round_winner tournament<TBlackAgent, TWhiteAgent>::run_simulation() {
 	   << endl << "-------------" << endl;
     }
     
+    // The agent that just moved thinks while its opponent does.
+    if(pondering && game.game_result() == playing) {
+      if(current_move == a_color)
+	background.start(player_a, game);
+      else
+	background.start(player_b, game);
+    }
+
     // Switch players.
     if(current_move == white)
       current_move = black;
@@ -224,28 +748,34 @@ round_winner tournament<TBlackAgent, TWhiteAgent>::run_simulation() {
     cout << bold << "...And the winner is..." << regular << endl;
 
   // Declare winner or tie.
-  if(game.lost_game(black) && game.lost_game(white)) {
+  game_outcome result = game.game_result();
+  if(result == tied) {
     winner.black = true;
     winner.white = true;
     if(display_winner)
       cout << "A tie!" << endl;
   }
-  else if(game.lost_game(black)) {
+  else if(result == white_won) {
     winner.black = false;
     winner.white = true;
     if(display_winner)
-      cout << "The white pawn: " << player_white.name() << "!" << endl;
+      cout << "The white pawn: "
+	   << (a_color == white ? player_a.name() : player_b.name())
+	   << "!" << endl;
   }
-  else if(game.lost_game(white)) {
+  else if(result == black_won) {
     winner.black = true;
     winner.white = false;
     if(display_winner)
-      cout << "The black pawn: " << player_black.name() <<  "!" << endl;
+      cout << "The black pawn: "
+	   << (a_color == black ? player_a.name() : player_b.name())
+	   << "!" << endl;
   }
   
   if(display_winner)
     cout << endl;
 
   return winner;
-} //tournament::run_simulation()
+} //tournament::play_game()
 
+#endif
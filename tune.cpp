@@ -0,0 +1,316 @@
+/*
+ * File: tune.cpp
+ * Author: Joshua T. Guerin
+ * Purpose: Fits the weights of the handcrafted evaluation (evaluation.h)
+ *          to recorded self-play positions.
+ *
+ * Method: Texel-style tuning.  Each position's evaluation v is mapped to
+ *         an expected score sigmoid(v), and the weights minimize the mean
+ *         squared error against the game's result (1 win, 0.5 tie, 0 loss)
+ *         by gradient descent (Adam).  Features are computed once, in
+ *         parallel batches directly on the packed records; every step's
+ *         loss and gradient are summed over the positions in parallel.
+ *
+ */
+
+
+#include <iostream>  // console io
+#include <cmath>     // exp(), sqrt()
+#include <getopt.h>  // getopt()
+#include <cstdlib>   // atoi(), atof()
+#include <algorithm> // remove(), min()
+#include <vector>    // Features, partial sums
+
+#include "evaluation.h"  // Features and weights
+#include "records.h"     // Recorded positions
+#include "thread_pool.h" // Parallel features and loss
+#include "types.h"       // Types associated with game/tournament.
+
+using namespace std;
+
+// Tuning Flags
+vector<string> record_files;
+string output_file="weights.txt";
+string initial_file;
+unsigned num_threads=0; // 0: one per hardware thread
+unsigned num_iterations=1000;
+double learning_rate=0.01;
+
+// Positions are read and featurized this many at a time.
+const unsigned batch_size=65536;
+
+
+struct training_set {
+  vector<double> features; // [position][num_features]
+  vector<double> targets;  // Result for the side to move, in [0, 1]
+  size_t size() const { return targets.size(); }
+};
+
+
+void parse_args(int argc, char *argv[]);
+/*
+ * Description: Parses command line arguments, sets associated flags.
+ */
+
+
+void help(string binary_name, string options);
+/*
+ * Description: Prints usage message if -h or --help flags arguments
+ *              are passed on the command line.
+ */
+
+
+bool load_positions(thread_pool& pool, training_set& data);
+/*
+ * Description: Reads every record file and appends each position's
+ *              features and target to data.
+ *
+ * Returns:
+ *     false - a file could not be read.
+ */
+
+
+double loss_and_gradient(thread_pool& pool, const training_set& data,
+			 const eval_weights& weights,
+			 double gradient[num_features]);
+/*
+ * Description: Mean squared error of sigmoid(evaluation) against the
+ *              targets, and its gradient with respect to the weights.
+ */
+
+
+int main(int argc, char *argv[]) {
+  parse_args(argc, argv);
+
+  if(record_files.empty()) {
+    cerr << "Error: No record files (see -f)." << endl;
+    return 1;
+  }
+
+  eval_weights weights;
+  if(!initial_file.empty() && !weights.load(initial_file)) {
+    cerr << "Error: Could not load weights " << initial_file << "." << endl;
+    return 1;
+  }
+
+  thread_pool pool(num_threads ? num_threads : thread_pool::default_threads());
+  training_set data;
+  if(!load_positions(pool, data))
+    return 1;
+  if(data.size() == 0) {
+    cerr << "Error: No positions to tune on." << endl;
+    return 1;
+  }
+
+  cout << bold << "Tuning on " << data.size() << " positions" << regular
+       << " (" << pool.size() << " threads)" << endl;
+
+  // Adam
+  const double beta1 = 0.9, beta2 = 0.999, epsilon = 1e-8;
+  double m[num_features] = {0}, v[num_features] = {0};
+  double gradient[num_features];
+  double loss = 0;
+
+  for(unsigned t=1; t<=num_iterations; t++) {
+    loss = loss_and_gradient(pool, data, weights, gradient);
+    if(t == 1 || t % 100 == 0)
+      cout << "Iteration " << t << ": loss " << loss << endl;
+
+    for(unsigned f=0; f<num_features; f++) {
+      m[f] = beta1 * m[f] + (1 - beta1) * gradient[f];
+      v[f] = beta2 * v[f] + (1 - beta2) * gradient[f] * gradient[f];
+      double m_hat = m[f] / (1 - pow(beta1, t));
+      double v_hat = v[f] / (1 - pow(beta2, t));
+      weights.weight[f] -= learning_rate * m_hat / (sqrt(v_hat) + epsilon);
+    }
+  }
+
+  loss = loss_and_gradient(pool, data, weights, gradient);
+  cout << bold << "Final loss: " << regular << loss << endl;
+  for(unsigned f=0; f<num_features; f++)
+    cout << "  " << eval_weights::feature_name(f) << ' '
+	 << weights.weight[f] << endl;
+
+  if(!weights.save(output_file)) {
+    cerr << "Error: Could not save weights " << output_file << "." << endl;
+    return 1;
+  }
+
+  return 0;
+}
+
+
+bool load_positions(thread_pool& pool, training_set& data) {
+  vector<position_record> batch(batch_size);
+
+  for(unsigned i=0; i<record_files.size(); i++) {
+    record_reader in(record_files[i]);
+    if(!in.is_open()) {
+      cerr << "Error: Could not read " << record_files[i] << "." << endl;
+      return false;
+    }
+
+    unsigned count;
+    do {
+      for(count=0; count<batch_size && in.next(batch[count]); count++)
+	;
+
+      size_t first = data.size();
+      data.features.resize((first + count) * num_features);
+      data.targets.resize(first + count);
+
+      // One slice of the batch per worker.
+      unsigned slice = (count + pool.size() - 1) / pool.size();
+      for(unsigned begin=0; begin<count; begin+=slice) {
+	unsigned end = min(count, begin + slice);
+	pool.submit([&batch, &data, first, begin, end]() {
+	    for(unsigned j=begin; j<end; j++) {
+	      record_features(batch[j],
+			      &data.features[(first + j) * num_features]);
+	      data.targets[first + j] = (batch[j].result + 1) / 2.0;
+	    }
+	  });
+      }
+      pool.wait();
+    } while(count == batch_size);
+  }
+
+  return true;
+}
+
+
+double loss_and_gradient(thread_pool& pool, const training_set& data,
+			 const eval_weights& weights,
+			 double gradient[num_features]) {
+  unsigned parts = pool.size();
+  size_t slice = (data.size() + parts - 1) / parts;
+  vector<double> losses(parts, 0);
+  vector<double> gradients(parts * num_features, 0);
+
+  for(unsigned p=0; p<parts; p++) {
+    pool.submit([&, p]() {
+	size_t begin = p * slice, end = min(data.size(), begin + slice);
+	double* partial = &gradients[p * num_features];
+
+	for(size_t i=begin; i<end; i++) {
+	  const double* features = &data.features[i * num_features];
+	  double s = 1 / (1 + exp(-weights.evaluate(features)));
+	  double error = s - data.targets[i];
+
+	  losses[p] += error * error;
+	  // d(error^2)/dw = 2 * error * s * (1 - s) * feature
+	  double scale = 2 * error * s * (1 - s);
+	  for(unsigned f=0; f<num_features; f++)
+	    partial[f] += scale * features[f];
+	}
+      });
+  }
+  pool.wait();
+
+  double loss = 0;
+  for(unsigned f=0; f<num_features; f++)
+    gradient[f] = 0;
+  for(unsigned p=0; p<parts; p++) {
+    loss += losses[p];
+    for(unsigned f=0; f<num_features; f++)
+      gradient[f] += gradients[p * num_features + f];
+  }
+
+  for(unsigned f=0; f<num_features; f++)
+    gradient[f] /= data.size();
+  return loss / data.size();
+}
+
+
+void parse_args(int argc, char *argv[]) {
+  int option;
+  opterr = 0;
+
+  // getopt_long arguments
+  string options = "f:hj:n:o:";
+  const struct option long_options[] =
+    {
+      {"file",        required_argument,  0, 'f'},
+      {"help",        no_argument,        0, 'h'},
+      {"threads",     required_argument,  0, 'j'},
+      {"iterations",  required_argument,  0, 'n'},
+      {"output",      required_argument,  0, 'o'},
+      {"rate",        required_argument,  0, 'R'},
+      {"weights",     required_argument,  0, 'W'},
+      {0,0,0,0},
+    };
+  int option_index;
+
+  option = getopt_long(argc, argv, options.c_str(),
+		       long_options, &option_index);
+
+  while(option != -1) {
+    switch(option) {
+    case 'f':
+      // Record file (may be repeated)
+      record_files.push_back(optarg);
+      break;
+    case 'h':
+      // Help flag
+      help(argv[0], options);
+      exit(0);
+      break;
+    case 'j':
+      // Number of worker threads
+      num_threads = atoi(optarg);
+      break;
+    case 'n':
+      // Number of gradient steps
+      num_iterations = atoi(optarg);
+      break;
+    case 'o':
+      // Output weights file
+      output_file = optarg;
+      break;
+    case 'R':
+      // Learning rate (long option only)
+      learning_rate = atof(optarg);
+      break;
+    case 'W':
+      // Initial weights (long option only)
+      initial_file = optarg;
+      break;
+    case '?':
+      cerr << "Error: Unrecognized argument or missing value." << endl
+	   << "See the -h option for usage." << endl;
+      exit(0);
+      break;
+    default:
+      cerr << "Error: Unknown argument: " << char(option) << endl;
+      exit(0);
+      break;
+    }
+
+    option = getopt_long(argc, argv, options.c_str(),
+			 long_options, &option_index);
+  }
+}
+
+
+void help(string binary_name, string options) {
+  options.erase(remove(options.begin(), options.end(), ':'), options.end());
+
+  cout << bold << "NAME\n\t" << binary_name << regular << " -- tunes evaluation weights on recorded positions" << endl
+       << bold << "SYNOPSIS: \n\t" << binary_name
+       << " [-" << options << "]" << regular << endl
+       << bold << "OPTIONS:" << regular << endl
+       << bold << "-f | --file name" << regular
+       << "      Record file from selfplay (repeat for several files)." << endl
+       << bold << "-h | --help" << regular
+       << "           Print this help." << endl
+       << bold << "-j | --threads n" << regular
+       << "      Uses " << bold << 'n' << regular << " worker threads (default: all hardware threads)." << endl
+       << bold << "-n | --iterations n" << regular
+       << "   Gradient steps (default: 1000)." << endl
+       << bold << "-o | --output name" << regular
+       << "    Weights file written (default: weights.txt)." << endl
+       << bold << "--rate r" << regular
+       << "              Learning rate (default: 0.01)." << endl
+       << bold << "--weights file" << regular
+       << "        Starts from the weights in " << bold << "file" << regular << " (default: mobility only)." << endl;
+}
@@ -15,6 +15,12 @@ enum direction {
   north, south, east, west, northwest, northeast, southwest, southeast
 };
 
+// Lower case direction names, indexed by direction (e.g., for output).
+const char* const direction_names[8] = {
+  "north", "south", "east", "west",
+  "northwest", "northeast", "southwest", "southeast"
+};
+
 // Pawn colors.
 enum player {black='b', white='w'};
 
@@ -28,6 +34,12 @@ struct round_winner {
 };
 
 
+enum game_outcome {
+  // State of a game as reported by isola::game_result().
+  playing, black_won, white_won, tied
+};
+
+
 struct location {
   /*
    * A location simply identifies one square's position (x, y) in the grid.
@@ -63,6 +75,16 @@ struct action {
   action (direction d, location s):move_to(d), remove(s) {};
 };
 
+template <typename... TAgents>
+struct agent_list {
+  /*
+   * A compile-time list of agent classes, e.g.,
+   *   agent_list<random_agent::agent, ordered_agent::agent>
+   * Used to instantiate a league between every listed agent.
+   */
+  static const unsigned size = sizeof...(TAgents);
+};
+
 /*
  * Formatting string (inserted into cout as though they were manipulators).
  * Notes: All are ansi escape codes, not necessarily cross-platform.